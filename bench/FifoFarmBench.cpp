@@ -0,0 +1,366 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+// Creates N fake "name-pid" FIFOs with a reader process and measures the control path.
+// Usage: vk-layer-flimes-bench [iterations] [app counts...]
+// Prints one JSON object per app count.
+
+#include "ExternalControl.hpp"
+#include "FpsPolicy.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QHash>
+#include <QDir>
+
+#include <algorithm>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+
+using namespace std;
+
+// Counts syscalls of the calling thread using the "raw_syscalls:sys_enter" tracepoint
+class SyscallCounter
+{
+public:
+    SyscallCounter()
+    {
+        QFile idFile("/sys/kernel/tracing/events/raw_syscalls/sys_enter/id");
+        if (!idFile.open(QFile::ReadOnly))
+        {
+            idFile.setFileName("/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id");
+            if (!idFile.open(QFile::ReadOnly))
+                return;
+        }
+
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = idFile.readAll().trimmed().toULongLong();
+
+        m_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    ~SyscallCounter()
+    {
+        if (m_fd > -1)
+            close(m_fd);
+    }
+
+    inline bool isOk() const
+    {
+        return (m_fd > -1);
+    }
+
+    quint64 value() const
+    {
+        quint64 count = 0;
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+static quint64 writeSyscalls()
+{
+    QFile f("/proc/self/io");
+    if (!f.open(QFile::ReadOnly))
+        return 0;
+    for (auto &&line : f.readAll().split('\n'))
+    {
+        if (line.startsWith("syscw:"))
+            return line.mid(6).trimmed().toULongLong();
+    }
+    return 0;
+}
+
+static double percentile(vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    sort(values.begin(), values.end());
+    return values[min<size_t>(values.size() - 1, values.size() * p)];
+}
+
+static int openFifo(int epollFd, const QByteArray &fifo)
+{
+    const int fd = open(fifo.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    return fd;
+}
+
+// Opens all FIFOs for reading and drains them until "ctrlFd" is closed
+static void runReader(const QStringList &fifos, int readyFd, int ctrlFd)
+{
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = ctrlFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, ctrlFd, &ev);
+
+    QHash<int, QByteArray> fifoPaths;
+    for (auto &&fifo : fifos)
+    {
+        const auto path = QFile::encodeName(fifo);
+        const int fd = openFifo(epollFd, path);
+        if (fd > -1)
+            fifoPaths.insert(fd, path);
+    }
+
+    const char ready = 1;
+    if (write(readyFd, &ready, 1) != 1)
+        _exit(1);
+    close(readyFd);
+
+    epoll_event events[64];
+    char buffer[4096];
+    for (;;)
+    {
+        const int n = epoll_wait(epollFd, events, 64, -1);
+        for (int i = 0; i < n; ++i)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == ctrlFd)
+                _exit(0);
+            while (read(fd, buffer, sizeof(buffer)) > 0)
+            {}
+
+            // The writer has closed the FIFO, a reopened one doesn't report the hang-up until the next writer leaves
+            if (events[i].events & EPOLLHUP)
+            {
+                const auto path = fifoPaths.take(fd);
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+
+                const int newFd = openFifo(epollFd, path);
+                if (newFd > -1)
+                    fifoPaths.insert(newFd, path);
+            }
+        }
+    }
+}
+
+static QJsonObject runBenchmark(int appsCount, int iterations)
+{
+    QJsonObject result;
+    result["apps"] = appsCount;
+
+    char tmpTemplate[] = "/tmp/vk-layer-flimes-bench-XXXXXX";
+    const QString tmpDir = mkdtemp(tmpTemplate);
+    if (tmpDir.isEmpty())
+        return result;
+
+    // ExternalControl uses "$TMPDIR/vk-layer-flimes"
+    setenv("TMPDIR", QFile::encodeName(tmpDir).constData(), 1);
+
+    const QString flimesDir = tmpDir + "/vk-layer-flimes";
+    QDir().mkpath(flimesDir);
+
+    // All FIFOs use our PID, so they are treated as alive
+    QStringList fifos;
+    for (int i = 0; i < appsCount; ++i)
+    {
+        fifos.push_back(QString("%1/bench%2-%3").arg(flimesDir).arg(i).arg(getpid()));
+        mkfifo(QFile::encodeName(fifos.back()).constData(), 0600);
+    }
+
+    int readyPipe[2] = {-1, -1};
+    int ctrlPipe[2] = {-1, -1};
+    pid_t readerPid = -1;
+
+    // Every return path has to stop the reader and remove the temporary directory
+    const auto closePipeEnd = [](int &fd) {
+        if (fd > -1)
+        {
+            close(fd);
+            fd = -1;
+        }
+    };
+    const auto cleanup = [&](bool killReader) {
+        closePipeEnd(readyPipe[0]);
+        closePipeEnd(readyPipe[1]);
+        closePipeEnd(ctrlPipe[0]);
+        closePipeEnd(ctrlPipe[1]); // The reader exits when this is closed
+        if (readerPid > 0)
+        {
+            if (killReader)
+                kill(readerPid, SIGKILL);
+            waitpid(readerPid, nullptr, 0);
+        }
+        QDir(tmpDir).removeRecursively();
+        return result;
+    };
+
+    if (pipe2(readyPipe, O_CLOEXEC) != 0 || pipe2(ctrlPipe, O_CLOEXEC) != 0)
+        return cleanup(false);
+
+    readerPid = fork();
+    if (readerPid == 0)
+    {
+        close(readyPipe[0]);
+        close(ctrlPipe[1]);
+        runReader(fifos, readyPipe[1], ctrlPipe[0]);
+    }
+    if (readerPid < 0)
+        return cleanup(false);
+    closePipeEnd(readyPipe[1]);
+    closePipeEnd(ctrlPipe[0]);
+
+    char ready = 0;
+    if (read(readyPipe[0], &ready, 1) != 1)
+        return cleanup(true);
+    closePipeEnd(readyPipe[0]);
+
+    {
+        QElapsedTimer timer;
+
+        timer.start();
+        FpsPolicy policy;
+        result["cold_scan_ms"] = timer.nsecsElapsed() / 1e6;
+
+        auto externalControl = policy.externalControl();
+        result["tracked_apps"] = static_cast<int>(externalControl->applications().size());
+
+        vector<double> refreshTimes;
+        for (int i = 0; i < iterations; ++i)
+        {
+            timer.start();
+            externalControl->refresh();
+            refreshTimes.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        result["refresh_ms_median"] = percentile(refreshTimes, 0.5);
+
+        // Time from FIFO creation to the application being tracked
+        bool added = false;
+        QObject::connect(externalControl, &ExternalControl::applicationAdded,
+                         [&] {
+            added = true;
+        });
+        const auto newFifo = QString("%1/bench-new-%2").arg(flimesDir).arg(getpid());
+        timer.start();
+        mkfifo(QFile::encodeName(newFifo).constData(), 0600);
+        while (!added && timer.elapsed() < 5000)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+        result["add_latency_ms"] = added ? timer.nsecsElapsed() / 1e6 : -1.0;
+
+        SyscallCounter syscallCounter;
+
+        vector<double> updateTimes;
+        quint64 syscalls = 0;
+        quint64 writes = 0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            policy.setLimit(FpsPolicy::ActiveTier, {true, 30.0 + (i % 2)});
+
+            const auto syscallsBefore = syscallCounter.isOk() ? syscallCounter.value() : 0;
+            const auto writesBefore = writeSyscalls();
+            timer.start();
+            policy.update();
+            updateTimes.push_back(timer.nsecsElapsed() / 1e6);
+            writes += writeSyscalls() - writesBefore;
+            if (syscallCounter.isOk())
+                syscalls += syscallCounter.value() - syscallsBefore;
+
+            // Reap io_uring completions
+            QCoreApplication::processEvents();
+        }
+        result["update_ms_median"] = percentile(updateTimes, 0.5);
+        result["update_ms_p95"] = percentile(updateTimes, 0.95);
+        // io_uring writes aren't counted by "/proc/self/io"
+        result["io_uring"] = externalControl->usesIoUring();
+        if (externalControl->usesIoUring())
+            result["write_syscalls_per_update"] = QJsonValue();
+        else
+            result["write_syscalls_per_update"] = static_cast<double>(writes) / iterations;
+        if (syscallCounter.isOk())
+            result["syscalls_per_update"] = static_cast<double>(syscalls) / iterations;
+        else
+            result["syscalls_per_update"] = QJsonValue();
+
+        vector<double> unchangedUpdateTimes;
+        for (int i = 0; i < iterations; ++i)
+        {
+            timer.start();
+            policy.update();
+            unchangedUpdateTimes.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        result["unchanged_update_ms_median"] = percentile(unchangedUpdateTimes, 0.5);
+
+        policy.shutdown();
+    }
+
+    return cleanup(false);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Each application uses a FIFO descriptor and a pidfd
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    auto args = app.arguments().mid(1);
+
+    const int iterations = args.isEmpty() ? 20 : args.takeFirst().toInt();
+
+    QList<int> appsCounts;
+    for (auto &&arg : args)
+        appsCounts.push_back(arg.toInt());
+    if (appsCounts.isEmpty())
+        appsCounts = {50, 500, 5000};
+
+    for (int appsCount : appsCounts)
+    {
+        const auto result = runBenchmark(appsCount, max(iterations, 1));
+        printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+        fflush(stdout);
+    }
+
+    return 0;
+}
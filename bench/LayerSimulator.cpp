@@ -0,0 +1,188 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+// Simulates an application running with the vk-layer-flimes layer: creates the FIFO, parses
+// the commands written by ExternalControl and runs a fake frame loop at the requested rate.
+// Every event is printed as a JSON line with CLOCK_MONOTONIC timestamps in nanoseconds.
+// Usage: vk-layer-flimes-layer-sim [name] [unlimited FPS]
+
+#include <filesystem>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+
+using namespace std;
+
+static volatile sig_atomic_t g_quit = 0;
+
+static int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static int openFifo(const string &path)
+{
+    return open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+}
+
+int main(int argc, char *argv[])
+{
+    const string name = (argc > 1) ? argv[1] : "layer-sim";
+    const double unlimitedFps = (argc > 2) ? atof(argv[2]) : 1000.0;
+
+    const char *tmpDir = getenv("TMPDIR");
+    const auto dir = filesystem::path((tmpDir && *tmpDir) ? tmpDir : "/tmp") / "vk-layer-flimes";
+    const auto fifoPath = (dir / (name + "-" + to_string(getpid()))).string();
+
+    error_code ec;
+    filesystem::create_directories(dir, ec);
+    if (mkfifo(fifoPath.c_str(), 0600) != 0 && errno != EEXIST)
+    {
+        perror("mkfifo");
+        return 1;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = [](int) {
+        g_quit = 1;
+    };
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    int fd = openFifo(fifoPath);
+    if (fd < 0)
+    {
+        perror("open");
+        return 1;
+    }
+
+    printf("{\"event\":\"start\",\"t_ns\":%lld,\"fifo\":\"%s\"}\n", static_cast<long long>(monotonicNs()), fifoPath.c_str());
+    fflush(stdout);
+
+    double fps = 0.0;
+    bool limitChanged = false;
+    string line;
+
+    int64_t nextFrame = monotonicNs();
+    int64_t statsStart = nextFrame;
+    uint64_t frame = 0;
+    uint64_t statsFrames = 0;
+
+    while (!g_quit)
+    {
+        const int64_t now = monotonicNs();
+        if (now >= nextFrame)
+        {
+            // Present a frame
+            ++frame;
+            ++statsFrames;
+            if (limitChanged)
+            {
+                printf("{\"event\":\"applied\",\"t_ns\":%lld,\"frame\":%llu,\"fps\":%.3f}\n", static_cast<long long>(now), static_cast<unsigned long long>(frame), fps);
+                limitChanged = false;
+            }
+            if (now - statsStart >= 1000000000)
+            {
+                printf("{\"event\":\"stats\",\"t_ns\":%lld,\"measured_fps\":%.3f}\n", static_cast<long long>(now), statsFrames * 1e9 / (now - statsStart));
+                statsStart = now;
+                statsFrames = 0;
+            }
+            fflush(stdout);
+
+            const double frameFps = (fps > 0.0) ? fps : unlimitedFps;
+            nextFrame += static_cast<int64_t>(1e9 / frameFps);
+            if (nextFrame < now)
+                nextFrame = now;
+            continue;
+        }
+
+        pollfd pfd = {fd, POLLIN, 0};
+        const int timeoutMs = static_cast<int>((nextFrame - now + 999999) / 1000000);
+        if (poll(&pfd, 1, timeoutMs) <= 0)
+            continue;
+
+        char buffer[256];
+        const ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            // The writer went away, reopen to avoid spinning on POLLHUP
+            close(fd);
+            fd = openFifo(fifoPath);
+            if (fd < 0)
+                break;
+            continue;
+        }
+        if (size < 0)
+            continue;
+
+        const int64_t receivedAt = monotonicNs();
+        for (ssize_t i = 0; i < size; ++i)
+        {
+            if (buffer[i] != '\n')
+            {
+                line += buffer[i];
+                continue;
+            }
+
+            if (line == "IMMEDIATE" || line == "AUTO")
+            {
+                printf("{\"event\":\"present_mode\",\"t_ns\":%lld,\"mode\":\"%s\"}\n", static_cast<long long>(receivedAt), line.c_str());
+            }
+            else
+            {
+                char *end = nullptr;
+                const double newFps = strtod(line.c_str(), &end);
+                if (end != line.c_str() && *end == '\0' && newFps >= 0.0)
+                {
+                    fps = newFps;
+                    limitChanged = true;
+                    nextFrame = receivedAt; // Apply the new pacing starting with the next frame
+                    printf("{\"event\":\"fps\",\"t_ns\":%lld,\"fps\":%.3f}\n", static_cast<long long>(receivedAt), fps);
+                }
+                else
+                {
+                    printf("{\"event\":\"unknown\",\"t_ns\":%lld}\n", static_cast<long long>(receivedAt));
+                }
+            }
+            line.clear();
+        }
+        fflush(stdout);
+    }
+
+    if (fd > -1)
+        close(fd);
+    unlink(fifoPath.c_str());
+
+    return 0;
+}
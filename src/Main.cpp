@@ -23,19 +23,12 @@
 */
 
 #include "MainWindow.hpp"
+#include "InstanceLock.hpp"
 
 #include <QApplication>
 #include <QMessageBox>
 #include <QDebug>
 
-#include <filesystem>
-
-#include <sys/stat.h>
-#include <unistd.h>
-#include <fcntl.h>
-
-using namespace std;
-
 int main(int argc, char *argv[])
 {
     qInstallMessageHandler([](QtMsgType t, const QMessageLogContext &c, const QString &s) {
@@ -53,36 +46,22 @@ int main(int argc, char *argv[])
 #endif
     app.setQuitOnLastWindowClosed(false);
 
-    const auto tmpPath = filesystem::temp_directory_path().concat(("/" + app.applicationName() + "." + QString(getenv("USER"))).toStdString());
-    if (filesystem::is_fifo(tmpPath))
-    {
-        const int fd = open(tmpPath.c_str(), O_WRONLY | O_NONBLOCK);
-        if (fd > -1)
-        {
-            close(fd);
-            QMessageBox::warning(
-                nullptr,
-                QString(),
-                "Application is already running",
-                QMessageBox::Ok
-            );
-            return -1;
-        }
-    }
-    else
+    InstanceLock instanceLock;
+    if (!instanceLock.tryLock())
     {
-        filesystem::remove(tmpPath);
-        mkfifo(tmpPath.c_str(), 0600);
+        QMessageBox::warning(
+            nullptr,
+            QString(),
+            "Application is already running",
+            QMessageBox::Ok
+        );
+        return -1;
     }
 
     MainWindow w;
-    if (const int fd = open(tmpPath.c_str(), O_RDONLY | O_NONBLOCK); fd > -1)
-    {
-        w.setOnQuitFn([=] {
-            close(fd);
-            filesystem::remove(tmpPath);
-        });
-    }
+    w.setOnQuitFn([&] {
+        instanceLock.release();
+    });
 
     return app.exec();
 }
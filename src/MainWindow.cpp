@@ -23,78 +23,43 @@
 */
 
 #include "MainWindow.hpp"
-#include "ExternalControl.hpp"
+#include "SettingsWidget.hpp"
 #include "X11ActiveWindow.hpp"
 #include "X11GlobalHotkey.hpp"
-#include "PowerSupply.hpp"
 #include "HotkeyDialog.hpp"
+#include "RulesDialog.hpp"
+#include "FpsPolicy.hpp"
 
 #include <QDialogButtonBox>
 #include <QSystemTrayIcon>
-#include <QDoubleSpinBox>
-#include <QStandardPaths>
 #include <QApplication>
-#include <QFormLayout>
-#include <QListWidget>
-#include <QToolButton>
 #include <QMessageBox>
-#include <QPushButton>
 #include <QDataStream>
 #include <QBoxLayout>
-#include <QCheckBox>
 #include <QSettings>
 #include <qevent.h>
 #include <QMenuBar>
 #include <QSpinBox>
-#include <QLabel>
 #include <QDebug>
 #include <QTimer>
 #include <QMenu>
 
-bool MainWindow::s_inactiveImmediateModeDefault = false;
-
 using namespace std;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , m_externalControl(make_unique<ExternalControl>())
-    , m_x11ActiveWindow(make_unique<X11ActiveWindow>())
+    , m_policy(make_unique<FpsPolicy>())
     , m_x11GlobalHotkey(make_unique<X11GlobalHotkey>())
-    , m_powerSupply(make_unique<PowerSupply>())
-    , m_settings(new QSettings(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + "/" + QCoreApplication::applicationName() + ".ini", QSettings::IniFormat, this))
+    , m_settings(new QSettings(FpsPolicy::settingsFilePath(), QSettings::IniFormat, this))
     , m_tray(new QSystemTrayIcon(this))
-    , m_activeFpsChecked(new QCheckBox("Active"))
-    , m_activeFps(new QDoubleSpinBox)
-    , m_inactiveFpsChecked(new QCheckBox("Inactive"))
-    , m_inactiveFps(new QDoubleSpinBox)
-    , m_batteryFpsChecked(new QCheckBox("Battery"))
-    , m_batteryFps(new QDoubleSpinBox)
-    , m_refresh(new QToolButton)
-    , m_appsList(new QListWidget)
-    , m_appSettingsWidget(new QWidget)
-    , m_appActiveEnabled(new QCheckBox(m_activeFpsChecked->text()))
-    , m_appInactiveEnabled(new QCheckBox(m_inactiveFpsChecked->text()))
-    , m_appBatteryEnabled(new QCheckBox(m_batteryFpsChecked->text()))
-    , m_inactiveImmediateModeEnabled(new QCheckBox("Inactive V-Sync OFF"))
-    , m_bypassImmediateModeEnabled(new QCheckBox("Bypass V-Sync OFF"))
-    , m_updateAppsFpsTimer(new QTimer(this))
     , m_bypassTimer(new QTimer(this))
+    , m_releaseTimer(new QTimer(this))
 {
-    s_inactiveImmediateModeDefault = m_settings->value("InactiveImmediateModeDefault").toBool();
-
-    for (auto &&group : m_settings->childGroups())
-    {
-        auto &settings = m_appSettings[group];
-        settings.modified = true;
-        settings.active = m_settings->value(group + "/Active", settings.active).toBool();
-        settings.inactive = m_settings->value(group + "/Inactive", settings.inactive).toBool();
-        settings.battery = m_settings->value(group + "/Battery", settings.battery).toBool();
-        settings.inactiveImmediateMode = m_settings->value(group + "/InactiveImmediateMode", settings.inactiveImmediateMode).toBool();
-        settings.bypassImmediateMode = m_settings->value(group + "/BypassImmediateMode", settings.bypassImmediateMode).toBool();
-        settings.immediateModeModified = (settings.inactiveImmediateMode || settings.bypassImmediateMode);
-    }
+    m_policy->load(*m_settings);
+    m_policy->setAppSettingsWriteBehind(true);
 
-    auto w = new QWidget;
+    const auto externalControl = m_policy->externalControl();
+    const auto x11ActiveWindow = m_policy->x11ActiveWindow();
 
     auto menu = new QMenu(this);
     menu->addAction("Show", this, [this] {
@@ -123,6 +88,8 @@ MainWindow::MainWindow(QWidget *parent)
     }
     mainMenu->addAction("&Set bypass duration", this, &MainWindow::setBypassDuration);
     mainMenu->addSeparator();
+    mainMenu->addAction("&Application rules", this, &MainWindow::editAppRules);
+    mainMenu->addSeparator();
     auto inactiveImmediateModeDefaultAct = mainMenu->addAction("&Disable V-Sync for inactive applications by default");
     mainMenu->addSeparator();
     mainMenu->addAction("&Quit", this, &MainWindow::quit, QKeySequence("Ctrl+Q"));
@@ -130,128 +97,19 @@ MainWindow::MainWindow(QWidget *parent)
     m_bypassAct->setCheckable(true);
 
     inactiveImmediateModeDefaultAct->setCheckable(true);
-    inactiveImmediateModeDefaultAct->setChecked(s_inactiveImmediateModeDefault);
-    if (!m_x11ActiveWindow->isOk())
+    inactiveImmediateModeDefaultAct->setChecked(m_policy->inactiveImmediateModeDefault());
+    if (!x11ActiveWindow->isOk())
         inactiveImmediateModeDefaultAct->setVisible(false);
 
-    m_activeFpsChecked->setChecked(m_settings->value("ActiveFpsChecked").toBool());
-    m_activeFps->setDecimals(4);
-    m_activeFps->setRange(1.0, 1000.0);
-    m_activeFps->setSuffix(" FPS");
-    m_activeFps->setValue(m_settings->value("ActiveFps", 60.0).toDouble());
-    m_activeFps->setEnabled(m_activeFpsChecked->isChecked());
-
-    if (m_x11ActiveWindow->isOk())
-    {
-        const QString commonInfo =
-            "Some X11 applications might not set the \"_NET_WM_PID\" property.\n"
-            "All these applications will be treated as inactive."
-        ;
-
-        m_inactiveFpsChecked->setToolTip(commonInfo + "\nTo workaround the issue, unset \"Inactive\" for this application.");
-        m_inactiveFpsChecked->setChecked(m_settings->value("InactiveFpsChecked").toBool());
-        m_inactiveFps->setDecimals(4);
-        m_inactiveFps->setRange(1.0, 1000.0);
-        m_inactiveFps->setSuffix(" FPS");
-        m_inactiveFps->setValue(m_settings->value("InactiveFps", 20.0).toDouble());
-        m_inactiveFps->setEnabled(m_inactiveFpsChecked->isChecked());
-
-        m_inactiveImmediateModeEnabled->setToolTip(commonInfo);
-    }
-
-    if (m_powerSupply->isOk())
-    {
-        m_batteryFpsChecked->setChecked(m_settings->value("BatteryFpsChecked").toBool());
-        m_batteryFps->setDecimals(4);
-        m_batteryFps->setRange(1.0, 1000.0);
-        m_batteryFps->setSuffix(" FPS");
-        m_batteryFps->setValue(m_settings->value("BatteryFps", 30.0).toDouble());
-        m_batteryFps->setEnabled(m_batteryFpsChecked->isChecked());
-    }
-
-    m_refresh->setIcon(QIcon::fromTheme("view-refresh"));
-    m_refresh->setToolTip("Refresh");
-
-    m_appSettingsWidget->hide();
-
-    m_appActiveEnabled->setToolTip("Allow FPS limit if application is active");
-    m_appInactiveEnabled->setToolTip("Allow FPS limit if application is inactive");
-    m_appBatteryEnabled->setToolTip("Allow FPS limit if system runs on battery");
-
-    m_updateAppsFpsTimer->setInterval(125);
-
     m_bypassTimer->setInterval(m_settings->value("BypassDuration").toInt() * 1000);
+    m_releaseTimer->setSingleShot(true);
+    m_releaseTimer->setInterval(s_releaseWidgetsTimeout);
 
-    auto hLine = new QFrame;
-    hLine->setFrameShape(QFrame::HLine);
-    hLine->setFrameShadow(QFrame::Sunken);
-
-    auto vLine1 = new QFrame;
-    vLine1->setFrameShape(QFrame::VLine);
-    vLine1->setFrameShadow(QFrame::Sunken);
-
-    auto vLine2 = new QFrame;
-    vLine2->setFrameShape(QFrame::VLine);
-    vLine2->setFrameShadow(QFrame::Sunken);
-
-    auto vLine3 = new QFrame;
-    vLine3->setFrameShape(QFrame::VLine);
-    vLine3->setFrameShadow(QFrame::Sunken);
-
-    auto appSettingsLayout = new QHBoxLayout(m_appSettingsWidget);
-    appSettingsLayout->setContentsMargins(0, 0, 0, 0);
-    appSettingsLayout->addWidget(vLine1);
-    appSettingsLayout->addStretch();
-    appSettingsLayout->addWidget(m_appActiveEnabled);
-    appSettingsLayout->addWidget(m_appInactiveEnabled);
-    appSettingsLayout->addWidget(m_appBatteryEnabled);
-    appSettingsLayout->addWidget(vLine2);
-    if (m_x11ActiveWindow->isOk())
-    {
-        appSettingsLayout->addWidget(m_inactiveImmediateModeEnabled);
-    }
-    appSettingsLayout->addWidget(m_bypassImmediateModeEnabled);
-    appSettingsLayout->addStretch();
-    appSettingsLayout->addWidget(vLine3);
-
-    auto topLayout = new QFormLayout;
-    topLayout->addRow(m_activeFpsChecked, m_activeFps);
-    if (m_x11ActiveWindow->isOk())
-        topLayout->addRow(m_inactiveFpsChecked, m_inactiveFps);
-    if (m_powerSupply->isOk())
-        topLayout->addRow(m_batteryFpsChecked, m_batteryFps);
-
-    auto bottomLayout = new QGridLayout;
-    bottomLayout->addWidget(hLine, 0, 0, 1, 3);
-    bottomLayout->addWidget(new QLabel("Available applications"), 1, 0, 1, 1);
-    bottomLayout->addWidget(m_appSettingsWidget, 1, 1, 1, 1);
-    bottomLayout->addWidget(m_refresh, 1, 2, 1, 1);
-    bottomLayout->addWidget(m_appsList, 2, 0, 1, 3);
-
-    auto mainLayout = new QVBoxLayout(w);
-    mainLayout->addLayout(topLayout);
-    mainLayout->addLayout(bottomLayout);
-
-    connect(m_externalControl.get(), &ExternalControl::applicationsChanged,
-            this, &MainWindow::updateAppsList);
-    connect(m_x11ActiveWindow.get(), &X11ActiveWindow::activeWindowPidChanged,
-            this, [this](pid_t pid) {
-        m_activeWindowPid = pid;
-        updateAppsFps();
-    });
     connect(m_x11GlobalHotkey.get(), &X11GlobalHotkey::activated,
             this, [this](const KeySequence &keySeq) {
         Q_UNUSED(keySeq)
         toggleBypass();
     });
-    connect(m_powerSupply.get(), &PowerSupply::powerSourceChanged,
-            this, [this] {
-        auto font = m_batteryFpsChecked->font();
-        font.setBold(m_powerSupply->isBattery());
-        m_batteryFpsChecked->setFont(font);
-
-        updateAppsFpsLater();
-    });
 
     connect(m_tray, &QSystemTrayIcon::activated,
             this, [this](QSystemTrayIcon::ActivationReason reason) {
@@ -265,84 +123,23 @@ MainWindow::MainWindow(QWidget *parent)
             m_bypassTimer->start();
         else
             m_bypassTimer->stop();
-        centralWidget()->setEnabled(!checked);
-        updateAppsFpsLater();
+        if (m_settingsWidget)
+            m_settingsWidget->setEnabled(!checked);
+        m_policy->setBypass(checked);
     });
     connect(inactiveImmediateModeDefaultAct, &QAction::toggled,
-            this, [this](bool checked) {
-        bool changed = false;
-        s_inactiveImmediateModeDefault = checked;
-        for (auto &&settings : m_appSettings)
-        {
-            if (!settings.modified && settings.inactiveImmediateMode != s_inactiveImmediateModeDefault)
-            {
-                settings.inactiveImmediateMode = s_inactiveImmediateModeDefault;
-                if (settings.inactiveImmediateMode)
-                    settings.immediateModeModified = true;
-                changed = true;
-            }
-        }
-        if (changed)
-        {
-            appsListSelectionChanged();
-            updateAppsFpsLater();
-        }
-    });
-
-    connect(m_activeFpsChecked, &QCheckBox::toggled,
-            m_activeFps, &QDoubleSpinBox::setEnabled);
-    connect(m_inactiveFpsChecked, &QCheckBox::toggled,
-            m_inactiveFps, &QDoubleSpinBox::setEnabled);
-    connect(m_batteryFpsChecked, &QCheckBox::toggled,
-            m_batteryFps, &QDoubleSpinBox::setEnabled);
-
-    connect(m_refresh, &QToolButton::clicked,
-            m_externalControl.get(), &ExternalControl::refresh);
-
-    connect(m_activeFpsChecked, &QCheckBox::toggled,
-            this, &MainWindow::updateAppsFpsLater);
-    connect(m_activeFps, qOverload<double>(&QDoubleSpinBox::valueChanged),
-            this, &MainWindow::updateAppsFpsLater);
-    connect(m_inactiveFpsChecked, &QCheckBox::toggled,
-            this, &MainWindow::updateAppsFpsLater);
-    connect(m_inactiveFps, qOverload<double>(&QDoubleSpinBox::valueChanged),
-            this, &MainWindow::updateAppsFpsLater);
-    connect(m_batteryFpsChecked, &QCheckBox::toggled,
-            this, &MainWindow::updateAppsFpsLater);
-    connect(m_batteryFps, qOverload<double>(&QDoubleSpinBox::valueChanged),
-            this, &MainWindow::updateAppsFpsLater);
-
-    connect(m_appsList->selectionModel(), &QItemSelectionModel::selectionChanged,
-            this, &MainWindow::appsListSelectionChanged);
-
-    connect(m_appActiveEnabled, &QCheckBox::toggled,
-            this, &MainWindow::changeCurrAppSettings);
-    connect(m_appInactiveEnabled, &QCheckBox::toggled,
-            this, &MainWindow::changeCurrAppSettings);
-    connect(m_appBatteryEnabled, &QCheckBox::toggled,
-            this, &MainWindow::changeCurrAppSettings);
-    connect(m_inactiveImmediateModeEnabled, &QCheckBox::toggled,
-            this, &MainWindow::changeCurrAppSettings);
-    connect(m_bypassImmediateModeEnabled, &QCheckBox::toggled,
-            this, &MainWindow::changeCurrAppSettings);
-
-    connect(m_updateAppsFpsTimer, &QTimer::timeout,
-            this, &MainWindow::updateAppsFps);
+            m_policy.get(), &FpsPolicy::setInactiveImmediateModeDefault);
 
     connect(m_bypassTimer, &QTimer::timeout,
             this, [this] {
         m_bypassAct->setChecked(false);
     });
+    connect(m_releaseTimer, &QTimer::timeout,
+            this, &MainWindow::releaseSettingsWidget);
 
-    updateAppsList();
-
-    if (m_x11ActiveWindow->isOk())
-        QCoreApplication::instance()->installNativeEventFilter(m_x11ActiveWindow.get());
     if (m_x11GlobalHotkey->isOk())
         QCoreApplication::instance()->installNativeEventFilter(m_x11GlobalHotkey.get());
 
-    setCentralWidget(w);
-
     if (m_x11GlobalHotkey->isOk())
     {
         const auto data = QByteArray::fromBase64(m_settings->value("BypassHotkey").toByteArray());
@@ -356,7 +153,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     m_geo = QByteArray::fromBase64(m_settings->value("Geometry").toByteArray());
 
-    if (!m_externalControl->isOk())
+    if (!externalControl->isOk())
     {
         QTimer::singleShot(0, this, [this] {
             QMessageBox::critical(
@@ -383,8 +180,6 @@ MainWindow::MainWindow(QWidget *parent)
 }
 MainWindow::~MainWindow()
 {
-    if (m_x11ActiveWindow->isOk())
-        QCoreApplication::instance()->removeNativeEventFilter(m_x11ActiveWindow.get());
     if (m_x11GlobalHotkey->isOk())
         QCoreApplication::instance()->removeNativeEventFilter(m_x11GlobalHotkey.get());
 
@@ -412,36 +207,9 @@ void MainWindow::onQuit()
 
     m_settings->setValue("Visible", m_visibleOnQuit);
 
-    if (m_externalControl->isOk())
-    {
-        const double fps = m_activeFpsChecked->isChecked()
-            ? m_activeFps->value()
-            : 0.0
-        ;
-        for (auto &&app : m_externalControl->applications())
-        {
-            auto &settings = m_appSettings[app.name];
-            optional<bool> forceImmediate;
-            if (settings.inactiveImmediateMode || (settings.bypassImmediateMode && m_bypassAct->isChecked()))
-                forceImmediate = false;
-            m_externalControl->setData(app, settings.active ? fps : 0.0, forceImmediate);
-        }
-    }
-
-    m_settings->setValue("InactiveImmediateModeDefault", s_inactiveImmediateModeDefault);
+    m_policy->shutdown();
+    m_policy->save(*m_settings);
 
-    m_settings->setValue("ActiveFpsChecked", m_activeFpsChecked->isChecked());
-    m_settings->setValue("ActiveFps", m_activeFps->value());
-    if (m_x11ActiveWindow->isOk())
-    {
-        m_settings->setValue("InactiveFpsChecked", m_inactiveFpsChecked->isChecked());
-        m_settings->setValue("InactiveFps", m_inactiveFps->value());
-    }
-    if (m_powerSupply->isOk())
-    {
-        m_settings->setValue("BatteryFpsChecked", m_batteryFpsChecked->isChecked());
-        m_settings->setValue("BatteryFps", m_batteryFps->value());
-    }
     if (m_x11GlobalHotkey->isOk())
     {
         QByteArray data;
@@ -452,170 +220,33 @@ void MainWindow::onQuit()
     m_settings->setValue("BypassDuration", m_bypassTimer->interval() / 1000);
     m_settings->setValue("Geometry", m_geo.toBase64().constData());
 
-    for (auto it = m_appSettings.begin(), itEnd = m_appSettings.end(); it != itEnd; ++it)
-    {
-        auto &&settings = it.value();
-        if (!settings.modified)
-            continue;
-
-        m_settings->setValue(it.key() + "/Active", settings.active);
-        m_settings->setValue(it.key() + "/Inactive", settings.inactive);
-        m_settings->setValue(it.key() + "/Battery", settings.battery);
-        m_settings->setValue(it.key() + "/InactiveImmediateMode", settings.inactiveImmediateMode);
-        m_settings->setValue(it.key() + "/BypassImmediateMode", settings.bypassImmediateMode);
-    }
-
     if (m_onQuitFn)
         m_onQuitFn();
 
-    m_externalControl->cleanup();
-
     m_onQuitDone = true;
 }
 
-inline QListWidgetItem *MainWindow::getSelectedItem() const
-{
-    return m_appsList->selectedItems().value(0);
-}
-
 void MainWindow::toggleBypass()
 {
     m_bypassAct->setChecked(!m_bypassAct->isChecked());
 }
 
-void MainWindow::updateAppsList()
+void MainWindow::createSettingsWidget()
 {
-    QString currentAppName;
-
-    if (auto item = getSelectedItem())
-        currentAppName = item->data(Qt::UserRole).toString();
-
-    auto selectionModel = m_appsList->selectionModel();
-    selectionModel->blockSignals(true);
-    m_appsList->clear();
-    selectionModel->blockSignals(false);
-
-    for (auto &&app : m_externalControl->applications())
-    {
-        auto item = new QListWidgetItem(QString("%1 (%2)").arg(app.name).arg(app.pid));
-        item->setData(Qt::UserRole, app.name);
-
-        m_appsList->addItem(item);
-
-        if (m_appsList->currentItem() == nullptr && app.name == currentAppName)
-            m_appsList->setCurrentItem(item);
-    }
-
-    if (!m_appsList->currentItem() && !currentAppName.isEmpty())
-        appsListSelectionChanged();
-
-    updateAppsFpsLater();
-}
-
-void MainWindow::updateAppsFpsLater()
-{
-    m_updateAppsFpsTimer->start();
-}
-void MainWindow::updateAppsFps()
-{
-    m_updateAppsFpsTimer->stop();
-
-    const double activeFps = m_activeFpsChecked->isChecked()
-        ? m_activeFps->value()
-        : 0.0
-    ;
-    const double inactiveFps = m_inactiveFpsChecked->isChecked()
-        ? m_inactiveFps->value()
-        : activeFps
-    ;
-    const double batteryFps = m_batteryFpsChecked->isChecked()
-        ? m_batteryFps->value()
-        : activeFps
-    ;
-
-    const bool battery = (m_powerSupply->isOk() && m_powerSupply->isBattery());
-    const bool bypass = m_bypassAct->isChecked();
-
-    for (auto &&app : m_externalControl->applications())
-    {
-        const bool active = (!m_x11ActiveWindow->isOk() || app.pid == m_activeWindowPid);
-        auto &settings = m_appSettings[app.name];
-
-        double fps = 0.0;
-        optional<bool> forceImmediate;
-
-        if (settings.inactiveImmediateMode)
-            forceImmediate = !active;
-
-        if (settings.bypassImmediateMode && (!forceImmediate.has_value() || bypass))
-            forceImmediate = bypass;
-
-        if (!bypass)
-        {
-            if (settings.active)
-                fps = activeFps;
-            if (!active && settings.inactive)
-                fps = inactiveFps;
-            if (battery && settings.battery && (fps == 0.0 || batteryFps < fps))
-                fps = batteryFps;
-        }
-
-        if (settings.immediateModeModified && !settings.inactiveImmediateMode && !settings.bypassImmediateMode)
-        {
-            Q_ASSERT(!forceImmediate.has_value());
-            forceImmediate = false;
-            settings.immediateModeModified = false;
-        }
-
-        m_externalControl->setData(app, fps, forceImmediate);
-    }
-}
-
-void MainWindow::changeCurrAppSettings()
-{
-    auto item = getSelectedItem();
-    if (!item)
+    if (m_settingsWidget)
         return;
 
-    auto &settings = m_appSettings[item->data(Qt::UserRole).toString()];
-    settings.modified = true;
-    settings.active = m_appActiveEnabled->isChecked();
-    settings.inactive = m_appInactiveEnabled->isChecked();
-    settings.battery = m_appBatteryEnabled->isChecked();
-    settings.inactiveImmediateMode = m_inactiveImmediateModeEnabled->isChecked();
-    settings.bypassImmediateMode = m_bypassImmediateModeEnabled->isChecked();
-    if (settings.inactiveImmediateMode || settings.bypassImmediateMode)
-        settings.immediateModeModified = true;
-
-    updateAppsFpsLater();
+    m_settingsWidget = new SettingsWidget(m_policy.get());
+    m_settingsWidget->setEnabled(!m_bypassAct->isChecked());
+    setCentralWidget(m_settingsWidget);
 }
-
-void MainWindow::appsListSelectionChanged()
+void MainWindow::releaseSettingsWidget()
 {
-    auto item = getSelectedItem();
-    if (!item)
-    {
-        m_appSettingsWidget->hide();
+    if (!m_settingsWidget || isVisible())
         return;
-    }
-
-    QSignalBlocker blocker[] {
-        QSignalBlocker(m_appActiveEnabled),
-        QSignalBlocker(m_appInactiveEnabled),
-        QSignalBlocker(m_appBatteryEnabled),
-        QSignalBlocker(m_inactiveImmediateModeEnabled),
-        QSignalBlocker(m_bypassImmediateModeEnabled),
-    };
-
-    auto &settings = m_appSettings[item->data(Qt::UserRole).toString()];
 
-    m_appActiveEnabled->setChecked(settings.active);
-    m_appInactiveEnabled->setChecked(settings.inactive);
-    m_appBatteryEnabled->setChecked(settings.battery);
-    m_inactiveImmediateModeEnabled->setChecked(settings.inactiveImmediateMode);
-    m_bypassImmediateModeEnabled->setChecked(settings.bypassImmediateMode);
-
-    m_appSettingsWidget->show();
+    delete takeCentralWidget();
+    m_settingsWidget = nullptr;
 }
 
 void MainWindow::setBypassHotkey()
@@ -667,6 +298,20 @@ void MainWindow::setBypassDuration()
         m_bypassTimer->start();
 }
 
+void MainWindow::editAppRules()
+{
+    RulesDialog d(this);
+    d.setRules(m_policy->appRules().rules());
+
+    if (d.exec() != QDialog::Accepted)
+        return;
+
+    m_policy->setAppRules(d.getRules());
+
+    if (m_settingsWidget)
+        m_settingsWidget->updateAppItemToolTips();
+}
+
 void MainWindow::registerHotkey()
 {
     if (m_x11GlobalHotkey->registerKeySequence(m_bypassHotkey))
@@ -691,12 +336,23 @@ void MainWindow::quit()
     QCoreApplication::quit();
 }
 
+void MainWindow::setVisible(bool visible)
+{
+    // The widgets are created when needed, tray-only sessions might never show them
+    if (visible)
+    {
+        m_releaseTimer->stop();
+        createSettingsWidget();
+    }
+    QMainWindow::setVisible(visible);
+}
+
 void MainWindow::showEvent(QShowEvent *e)
 {
     if (m_canAutoRefresh)
     {
-        if (!m_externalControl->applications().empty())
-            m_externalControl->refresh();
+        if (!m_policy->externalControl()->applications().empty())
+            m_policy->externalControl()->refresh();
         m_canAutoRefresh = false;
     }
     if (!m_geo.isEmpty())
@@ -709,6 +365,7 @@ void MainWindow::showEvent(QShowEvent *e)
 void MainWindow::hideEvent(QHideEvent *e)
 {
     m_canAutoRefresh = true;
+    m_releaseTimer->start();
     m_geo = saveGeometry();
     QMainWindow::hideEvent(e);
 }
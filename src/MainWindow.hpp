@@ -27,21 +27,14 @@
 #include "KeySequence.hpp"
 
 #include <QMainWindow>
-#include <QHash>
 
 #include <functional>
 
-class ExternalControl;
-class X11ActiveWindow;
 class X11GlobalHotkey;
-class PowerSupply;
+class SettingsWidget;
+class FpsPolicy;
 
-class QListWidgetItem;
 class QSystemTrayIcon;
-class QDoubleSpinBox;
-class QListWidget;
-class QToolButton;
-class QCheckBox;
 class QSettings;
 class QAction;
 class QTimer;
@@ -52,21 +45,7 @@ class MainWindow : public QMainWindow
 
     using OnQuitFn = std::function<void()>;
 
-    static bool s_inactiveImmediateModeDefault;
-
-    struct AppSettings
-    {
-        bool modified = false;
-
-        bool active = true;
-        bool inactive = true;
-        bool battery = true;
-
-        bool inactiveImmediateMode = s_inactiveImmediateModeDefault;
-        bool bypassImmediateMode = false;
-
-        bool immediateModeModified = (inactiveImmediateMode || bypassImmediateMode);
-    };
+    static constexpr int s_releaseWidgetsTimeout = 10 * 60 * 1000; // Hidden time in ms
 
 public:
     MainWindow(QWidget *parent = nullptr);
@@ -74,26 +53,22 @@ public:
 
     void setOnQuitFn(const OnQuitFn &fn);
 
+    void setVisible(bool visible) override;
+
 private:
     void beforeQuit();
     void onQuit();
 
-    inline QListWidgetItem *getSelectedItem() const;
-
     void toggleBypass();
 
-    void updateAppsList();
-
-    void updateAppsFpsLater();
-    void updateAppsFps();
-
-    void changeCurrAppSettings();
-
-    void appsListSelectionChanged();
+    void createSettingsWidget();
+    void releaseSettingsWidget();
 
     void setBypassHotkey();
     void setBypassDuration();
 
+    void editAppRules();
+
     void registerHotkey();
 
     void quit();
@@ -104,10 +79,8 @@ private:
     void closeEvent(QCloseEvent *e) override;
 
 private:
-    const std::unique_ptr<ExternalControl> m_externalControl;
-    const std::unique_ptr<X11ActiveWindow> m_x11ActiveWindow;
+    const std::unique_ptr<FpsPolicy> m_policy;
     const std::unique_ptr<X11GlobalHotkey> m_x11GlobalHotkey;
-    const std::unique_ptr<PowerSupply> m_powerSupply;
 
     QSettings *const m_settings;
 
@@ -115,33 +88,11 @@ private:
 
     QAction *m_bypassAct = nullptr;
 
-    QCheckBox *const m_activeFpsChecked;
-    QDoubleSpinBox *const m_activeFps;
-
-    QCheckBox *const m_inactiveFpsChecked;
-    QDoubleSpinBox *const m_inactiveFps;
-
-    QCheckBox *const m_batteryFpsChecked;
-    QDoubleSpinBox *const m_batteryFps;
-
-    QToolButton *const m_refresh;
-    QListWidget *const m_appsList;
-
-    QWidget *const m_appSettingsWidget;
-    QCheckBox *const m_appActiveEnabled;
-    QCheckBox *const m_appInactiveEnabled;
-    QCheckBox *const m_appBatteryEnabled;
-    QCheckBox *const m_inactiveImmediateModeEnabled;
-    QCheckBox *const m_bypassImmediateModeEnabled;
-
-    QHash<QString, AppSettings> m_appSettings;
-
-    QTimer *const m_updateAppsFpsTimer;
-
-    pid_t m_activeWindowPid = 0;
+    SettingsWidget *m_settingsWidget = nullptr; // Created when shown, released after being hidden for a while
 
     KeySequence m_bypassHotkey;
     QTimer *const m_bypassTimer;
+    QTimer *const m_releaseTimer;
 
     bool m_canAutoRefresh = false;
 
@@ -0,0 +1,169 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "RulesDialog.hpp"
+
+#include <QDialogButtonBox>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QMessageBox>
+#include <QComboBox>
+
+using namespace std;
+
+RulesDialog::RulesDialog(QWidget *parent)
+    : QDialog(parent)
+    , m_table(new QTableWidget(0, ColumnCount))
+    , m_add(new QPushButton("Add"))
+    , m_remove(new QPushButton("Remove"))
+    , m_up(new QPushButton("Up"))
+    , m_down(new QPushButton("Down"))
+{
+    setWindowTitle("Application rules");
+
+    m_table->setHorizontalHeaderLabels({"Syntax", "Pattern", "Profile", "Ignore"});
+    m_table->horizontalHeader()->setSectionResizeMode(PatternColumn, QHeaderView::Stretch);
+    m_table->horizontalHeader()->setSectionResizeMode(ProfileColumn, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setToolTip(
+        "The first rule whose pattern matches the whole application name is used.\n"
+        "Matching applications use the settings of the profile name or aren't controlled if ignored."
+    );
+
+    auto bb = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+
+    connect(m_add, &QPushButton::clicked,
+            this, [this] {
+        addRule(AppRules::Rule());
+        m_table->selectRow(m_table->rowCount() - 1);
+        m_table->editItem(m_table->item(m_table->rowCount() - 1, PatternColumn));
+    });
+    connect(m_remove, &QPushButton::clicked,
+            this, [this] {
+        if (m_table->currentRow() > -1)
+            m_table->removeRow(m_table->currentRow());
+    });
+    connect(m_up, &QPushButton::clicked,
+            this, [this] {
+        moveRule(-1);
+    });
+    connect(m_down, &QPushButton::clicked,
+            this, [this] {
+        moveRule(1);
+    });
+
+    connect(bb, &QDialogButtonBox::accepted,
+            this, &QDialog::accept);
+    connect(bb, &QDialogButtonBox::rejected,
+            this, &QDialog::reject);
+
+    auto l = new QGridLayout(this);
+    l->addWidget(m_table, 0, 0, 1, 4);
+    l->addWidget(m_add, 1, 0, 1, 1);
+    l->addWidget(m_remove, 1, 1, 1, 1);
+    l->addWidget(m_up, 1, 2, 1, 1);
+    l->addWidget(m_down, 1, 3, 1, 1);
+    l->addWidget(bb, 2, 0, 1, 4);
+
+    resize(560, 320);
+}
+RulesDialog::~RulesDialog()
+{
+}
+
+void RulesDialog::setRules(const vector<AppRules::Rule> &rules)
+{
+    m_table->setRowCount(0);
+    for (auto &&rule : rules)
+        addRule(rule);
+}
+vector<AppRules::Rule> RulesDialog::getRules() const
+{
+    vector<AppRules::Rule> rules;
+    for (int row = 0; row < m_table->rowCount(); ++row)
+    {
+        AppRules::Rule rule;
+        rule.syntax = static_cast<AppRules::Syntax>(static_cast<QComboBox *>(m_table->cellWidget(row, SyntaxColumn))->currentIndex());
+        rule.pattern = m_table->item(row, PatternColumn)->text().trimmed();
+        rule.profile = m_table->item(row, ProfileColumn)->text().trimmed();
+        rule.ignore = (m_table->item(row, IgnoreColumn)->checkState() == Qt::Checked);
+        rules.push_back(rule);
+    }
+    return rules;
+}
+
+void RulesDialog::addRule(const AppRules::Rule &rule)
+{
+    const int row = m_table->rowCount();
+    m_table->insertRow(row);
+
+    // Same order as "AppRules::Syntax"
+    auto syntax = new QComboBox;
+    syntax->addItems({"Glob", "Regex"});
+    syntax->setCurrentIndex(rule.syntax);
+    m_table->setCellWidget(row, SyntaxColumn, syntax);
+
+    m_table->setItem(row, PatternColumn, new QTableWidgetItem(rule.pattern));
+    m_table->setItem(row, ProfileColumn, new QTableWidgetItem(rule.profile));
+
+    auto ignore = new QTableWidgetItem;
+    ignore->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+    ignore->setCheckState(rule.ignore ? Qt::Checked : Qt::Unchecked);
+    m_table->setItem(row, IgnoreColumn, ignore);
+}
+void RulesDialog::moveRule(int offset)
+{
+    const int row = m_table->currentRow();
+    const int newRow = row + offset;
+    if (row < 0 || newRow < 0 || newRow >= m_table->rowCount())
+        return;
+
+    auto rules = getRules();
+    swap(rules[row], rules[newRow]);
+    setRules(rules);
+
+    m_table->selectRow(newRow);
+}
+
+void RulesDialog::done(int result)
+{
+    if (result == QDialog::Accepted)
+    {
+        const auto rules = getRules();
+        for (size_t i = 0; i < rules.size(); ++i)
+        {
+            if (AppRules::compile(rules[i]).pattern().isEmpty())
+            {
+                m_table->selectRow(i);
+                QMessageBox::warning(this, windowTitle(), QString("Invalid pattern: \"%1\"").arg(rules[i].pattern));
+                return;
+            }
+        }
+    }
+    QDialog::done(result);
+}
@@ -0,0 +1,68 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "AppRules.hpp"
+
+#include <QDialog>
+
+class QTableWidget;
+class QPushButton;
+
+class RulesDialog : public QDialog
+{
+    Q_OBJECT
+
+    enum Column
+    {
+        SyntaxColumn,
+        PatternColumn,
+        ProfileColumn,
+        IgnoreColumn,
+
+        ColumnCount
+    };
+
+public:
+    RulesDialog(QWidget *parent = nullptr);
+    ~RulesDialog();
+
+    void setRules(const std::vector<AppRules::Rule> &rules);
+    std::vector<AppRules::Rule> getRules() const;
+
+private:
+    void addRule(const AppRules::Rule &rule);
+    void moveRule(int offset);
+
+    void done(int result) override;
+
+private:
+    QTableWidget *const m_table;
+
+    QPushButton *const m_add;
+    QPushButton *const m_remove;
+    QPushButton *const m_up;
+    QPushButton *const m_down;
+};
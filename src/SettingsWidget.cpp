@@ -0,0 +1,629 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "SettingsWidget.hpp"
+#include "X11ActiveWindow.hpp"
+#include "X11IdleMonitor.hpp"
+#include "PowerSupply.hpp"
+#include "ThermalSource.hpp"
+#include "FpsPolicy.hpp"
+
+#include <QRegularExpressionValidator>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QListWidget>
+#include <QToolButton>
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QLabel>
+
+using namespace std;
+
+static void setFpsSpinBoxMode(QDoubleSpinBox *spinBox, FpsPolicy::LimitMode mode)
+{
+    switch (mode)
+    {
+        case FpsPolicy::AbsoluteLimit:
+            spinBox->setDecimals(4);
+            spinBox->setRange(1.0, 1000.0);
+            spinBox->setPrefix(QString());
+            spinBox->setSuffix(" FPS");
+            break;
+        case FpsPolicy::RefreshDivisorLimit:
+            spinBox->setDecimals(0);
+            spinBox->setRange(1.0, 16.0);
+            spinBox->setPrefix("Refresh rate / ");
+            spinBox->setSuffix(QString());
+            break;
+        case FpsPolicy::RefreshMinusLimit:
+            spinBox->setDecimals(1);
+            spinBox->setRange(0.0, 100.0);
+            spinBox->setPrefix("Refresh rate - ");
+            spinBox->setSuffix(" FPS");
+            break;
+    }
+}
+
+SettingsWidget::SettingsWidget(FpsPolicy *policy, QWidget *parent)
+    : QWidget(parent)
+    , m_policy(policy)
+    , m_activeFpsChecked(new QCheckBox("Active", this))
+    , m_activeFpsMode(new QComboBox(this))
+    , m_activeFps(new QDoubleSpinBox(this))
+    , m_windowedFpsChecked(new QCheckBox("Windowed", this))
+    , m_windowedFpsMode(new QComboBox(this))
+    , m_windowedFps(new QDoubleSpinBox(this))
+    , m_inactiveFpsChecked(new QCheckBox("Inactive", this))
+    , m_inactiveFpsMode(new QComboBox(this))
+    , m_inactiveFps(new QDoubleSpinBox(this))
+    , m_hiddenFpsChecked(new QCheckBox("Hidden", this))
+    , m_hiddenFpsMode(new QComboBox(this))
+    , m_hiddenFps(new QDoubleSpinBox(this))
+    , m_idleFpsChecked(new QCheckBox("Idle", this))
+    , m_idleFpsMode(new QComboBox(this))
+    , m_idleFps(new QDoubleSpinBox(this))
+    , m_idleTimeout(new QSpinBox(this))
+    , m_batteryFpsChecked(new QCheckBox("Battery", this))
+    , m_batteryFpsMode(new QComboBox(this))
+    , m_batteryFps(new QDoubleSpinBox(this))
+    , m_batteryCurve(new QLineEdit(this))
+    , m_thermalChecked(new QCheckBox("Thermal", this))
+    , m_thermalCeiling(new QDoubleSpinBox(this))
+    , m_refresh(new QToolButton(this))
+    , m_appsList(new QListWidget(this))
+    , m_appSettingsWidget(new QWidget(this))
+    , m_appActiveEnabled(new QCheckBox(m_activeFpsChecked->text(), this))
+    , m_appActiveFps(new QDoubleSpinBox(this))
+    , m_appWindowedEnabled(new QCheckBox(m_windowedFpsChecked->text(), this))
+    , m_appInactiveEnabled(new QCheckBox(m_inactiveFpsChecked->text(), this))
+    , m_appInactiveFps(new QDoubleSpinBox(this))
+    , m_appBatteryEnabled(new QCheckBox(m_batteryFpsChecked->text(), this))
+    , m_appBatteryFps(new QDoubleSpinBox(this))
+    , m_appHiddenEnabled(new QCheckBox(m_hiddenFpsChecked->text(), this))
+    , m_appIdleEnabled(new QCheckBox(m_idleFpsChecked->text(), this))
+    , m_inactiveImmediateModeEnabled(new QCheckBox("Inactive V-Sync OFF", this))
+    , m_bypassImmediateModeEnabled(new QCheckBox("Bypass V-Sync OFF", this))
+{
+    const auto externalControl = m_policy->externalControl();
+    const auto x11ActiveWindow = m_policy->x11ActiveWindow();
+    const auto x11IdleMonitor = m_policy->x11IdleMonitor();
+    const auto powerSupply = m_policy->powerSupply();
+    const auto thermalSource = m_policy->thermalSource();
+
+    const pair<FpsPolicy::Tier, QComboBox *> fpsModes[] = {
+        {FpsPolicy::ActiveTier, m_activeFpsMode},
+        {FpsPolicy::WindowedTier, m_windowedFpsMode},
+        {FpsPolicy::InactiveTier, m_inactiveFpsMode},
+        {FpsPolicy::HiddenTier, m_hiddenFpsMode},
+        {FpsPolicy::IdleTier, m_idleFpsMode},
+        {FpsPolicy::BatteryTier, m_batteryFpsMode},
+    };
+    for (auto &&fpsMode : fpsModes)
+    {
+        if (FpsPolicy::hasRefreshModes(fpsMode.first))
+        {
+            // Same order as "FpsPolicy::LimitMode"
+            fpsMode.second->addItems({"FPS", "Divided refresh rate", "Refresh rate minus"});
+            fpsMode.second->setToolTip("Refresh rate of the monitor which shows the active window");
+        }
+        else
+        {
+            fpsMode.second->addItem("FPS");
+            fpsMode.second->setToolTip("Other applications can be shown on other monitors, only the active window limits can follow the refresh rate");
+        }
+    }
+
+    m_activeFpsChecked->setChecked(m_policy->limit(FpsPolicy::ActiveTier).enabled);
+    m_activeFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::ActiveTier).mode);
+    m_activeFpsMode->setEnabled(m_activeFpsChecked->isChecked());
+    setFpsSpinBoxMode(m_activeFps, m_policy->limit(FpsPolicy::ActiveTier).mode);
+    m_activeFps->setValue(m_policy->limit(FpsPolicy::ActiveTier).fps);
+    m_activeFps->setEnabled(m_activeFpsChecked->isChecked());
+
+    if (x11ActiveWindow->isOk())
+    {
+        const QString commonInfo = x11ActiveWindow->hasXRes()
+            ? "Some X11 applications might not set the \"_NET_WM_PID\" property.\n"
+              "The X-Resource extension is used for them, but remote clients will be treated as inactive."
+            : "Some X11 applications might not set the \"_NET_WM_PID\" property.\n"
+              "All these applications will be treated as inactive."
+        ;
+
+        m_windowedFpsChecked->setToolTip("Limit for the active application if its window is not fullscreen");
+        m_windowedFpsChecked->setChecked(m_policy->limit(FpsPolicy::WindowedTier).enabled);
+        m_windowedFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::WindowedTier).mode);
+        m_windowedFpsMode->setEnabled(m_windowedFpsChecked->isChecked());
+        setFpsSpinBoxMode(m_windowedFps, m_policy->limit(FpsPolicy::WindowedTier).mode);
+        m_windowedFps->setValue(m_policy->limit(FpsPolicy::WindowedTier).fps);
+        m_windowedFps->setEnabled(m_windowedFpsChecked->isChecked());
+
+        m_inactiveFpsChecked->setToolTip(commonInfo + "\nTo workaround the issue, unset \"Inactive\" for this application.");
+        m_inactiveFpsChecked->setChecked(m_policy->limit(FpsPolicy::InactiveTier).enabled);
+        m_inactiveFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::InactiveTier).mode);
+        m_inactiveFpsMode->setEnabled(m_inactiveFpsChecked->isChecked());
+        setFpsSpinBoxMode(m_inactiveFps, m_policy->limit(FpsPolicy::InactiveTier).mode);
+        m_inactiveFps->setValue(m_policy->limit(FpsPolicy::InactiveTier).fps);
+        m_inactiveFps->setEnabled(m_inactiveFpsChecked->isChecked());
+
+        m_hiddenFpsChecked->setToolTip("Limit for inactive applications whose windows are all minimized or hidden");
+        m_hiddenFpsChecked->setChecked(m_policy->limit(FpsPolicy::HiddenTier).enabled);
+        m_hiddenFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::HiddenTier).mode);
+        m_hiddenFpsMode->setEnabled(m_hiddenFpsChecked->isChecked());
+        setFpsSpinBoxMode(m_hiddenFps, m_policy->limit(FpsPolicy::HiddenTier).mode);
+        m_hiddenFps->setValue(m_policy->limit(FpsPolicy::HiddenTier).fps);
+        m_hiddenFps->setEnabled(m_hiddenFpsChecked->isChecked());
+
+        m_inactiveImmediateModeEnabled->setToolTip(commonInfo);
+    }
+
+    if (x11IdleMonitor->isOk())
+    {
+        m_idleFpsChecked->setToolTip("Limit for all applications if there was no keyboard or mouse input for a while");
+        m_idleFpsChecked->setChecked(m_policy->limit(FpsPolicy::IdleTier).enabled);
+        m_idleFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::IdleTier).mode);
+        m_idleFpsMode->setEnabled(m_idleFpsChecked->isChecked());
+        setFpsSpinBoxMode(m_idleFps, m_policy->limit(FpsPolicy::IdleTier).mode);
+        m_idleFps->setValue(m_policy->limit(FpsPolicy::IdleTier).fps);
+        m_idleFps->setEnabled(m_idleFpsChecked->isChecked());
+
+        m_idleTimeout->setRange(1, 240);
+        m_idleTimeout->setSuffix(" min");
+        m_idleTimeout->setValue(qMax(x11IdleMonitor->timeout() / 60, 1));
+        m_idleTimeout->setEnabled(m_idleFpsChecked->isChecked());
+    }
+
+    if (powerSupply->isOk())
+    {
+        m_batteryFpsChecked->setChecked(m_policy->limit(FpsPolicy::BatteryTier).enabled);
+        m_batteryFpsMode->setCurrentIndex(m_policy->limit(FpsPolicy::BatteryTier).mode);
+        m_batteryFpsMode->setEnabled(m_batteryFpsChecked->isChecked());
+        setFpsSpinBoxMode(m_batteryFps, m_policy->limit(FpsPolicy::BatteryTier).mode);
+        m_batteryFps->setValue(m_policy->limit(FpsPolicy::BatteryTier).fps);
+        m_batteryFps->setEnabled(m_batteryFpsChecked->isChecked());
+
+        m_batteryCurve->setToolTip("Battery FPS at or below the given capacity, e.g. \"50:30, 15:20\"");
+        m_batteryCurve->setPlaceholderText("capacity:FPS, ...");
+        m_batteryCurve->setValidator(new QRegularExpressionValidator(QRegularExpression(R"(^(\s*\d{1,3}\s*:\s*\d+(\.\d*)?\s*(,|$))*$)"), m_batteryCurve));
+        m_batteryCurve->setText(FpsPolicy::batteryCurveToString(m_policy->batteryCurve()));
+        m_batteryCurve->setEnabled(m_batteryFpsChecked->isChecked());
+    }
+
+    if (thermalSource->isOk())
+    {
+        m_thermalChecked->setToolTip("Lower the FPS limits when the temperature approaches the ceiling");
+        m_thermalChecked->setChecked(thermalSource->isEnabled());
+        m_thermalCeiling->setDecimals(1);
+        m_thermalCeiling->setRange(40.0, 120.0);
+        m_thermalCeiling->setSuffix(" °C");
+        m_thermalCeiling->setValue(thermalSource->ceiling());
+        m_thermalCeiling->setEnabled(m_thermalChecked->isChecked());
+    }
+
+    m_refresh->setIcon(QIcon::fromTheme("view-refresh"));
+    m_refresh->setToolTip("Refresh");
+
+    m_appSettingsWidget->hide();
+
+    m_appActiveEnabled->setToolTip("Allow FPS limit if application is active");
+    m_appWindowedEnabled->setToolTip("Allow windowed FPS limit if application is active, but not fullscreen");
+    m_appInactiveEnabled->setToolTip("Allow FPS limit if application is inactive");
+    m_appBatteryEnabled->setToolTip("Allow FPS limit if system runs on battery");
+    m_appHiddenEnabled->setToolTip("Allow FPS limit if application windows are minimized or hidden");
+    m_appIdleEnabled->setToolTip("Allow FPS limit if there was no keyboard or mouse input for a while");
+
+    for (auto appFps : {m_appActiveFps, m_appInactiveFps, m_appBatteryFps})
+    {
+        appFps->setDecimals(1);
+        appFps->setRange(0.0, 1000.0);
+        appFps->setSuffix(" FPS");
+        appFps->setSpecialValueText("Global");
+        appFps->setToolTip("FPS limit for this application, used instead of the global value if the limit is enabled");
+    }
+
+    auto hLine = new QFrame;
+    hLine->setFrameShape(QFrame::HLine);
+    hLine->setFrameShadow(QFrame::Sunken);
+
+    auto vLine1 = new QFrame;
+    vLine1->setFrameShape(QFrame::VLine);
+    vLine1->setFrameShadow(QFrame::Sunken);
+
+    auto vLine2 = new QFrame;
+    vLine2->setFrameShape(QFrame::VLine);
+    vLine2->setFrameShadow(QFrame::Sunken);
+
+    auto vLine3 = new QFrame;
+    vLine3->setFrameShape(QFrame::VLine);
+    vLine3->setFrameShadow(QFrame::Sunken);
+
+    auto appSettingsLayout = new QHBoxLayout(m_appSettingsWidget);
+    appSettingsLayout->setContentsMargins(0, 0, 0, 0);
+    appSettingsLayout->addWidget(vLine1);
+    appSettingsLayout->addStretch();
+    appSettingsLayout->addWidget(m_appActiveEnabled);
+    appSettingsLayout->addWidget(m_appActiveFps);
+    if (x11ActiveWindow->isOk())
+        appSettingsLayout->addWidget(m_appWindowedEnabled);
+    else
+        m_appWindowedEnabled->hide();
+    appSettingsLayout->addWidget(m_appInactiveEnabled);
+    appSettingsLayout->addWidget(m_appInactiveFps);
+    appSettingsLayout->addWidget(m_appBatteryEnabled);
+    appSettingsLayout->addWidget(m_appBatteryFps);
+    if (x11ActiveWindow->isOk())
+        appSettingsLayout->addWidget(m_appHiddenEnabled);
+    else
+        m_appHiddenEnabled->hide();
+    if (x11IdleMonitor->isOk())
+        appSettingsLayout->addWidget(m_appIdleEnabled);
+    else
+        m_appIdleEnabled->hide();
+    appSettingsLayout->addWidget(vLine2);
+    if (x11ActiveWindow->isOk())
+        appSettingsLayout->addWidget(m_inactiveImmediateModeEnabled);
+    else
+        m_inactiveImmediateModeEnabled->hide();
+    appSettingsLayout->addWidget(m_bypassImmediateModeEnabled);
+    appSettingsLayout->addStretch();
+    appSettingsLayout->addWidget(vLine3);
+
+    auto limitLayout = [&](QComboBox *fpsMode, QDoubleSpinBox *fps) {
+        auto layout = new QHBoxLayout;
+        if (x11ActiveWindow->hasRandR())
+            layout->addWidget(fpsMode);
+        else
+            fpsMode->hide();
+        layout->addWidget(fps, 1);
+        return layout;
+    };
+
+    // Widgets of unavailable sources are still owned by this widget, but never shown
+    auto hideWidgets = [](std::initializer_list<QWidget *> widgets) {
+        for (auto widget : widgets)
+            widget->hide();
+    };
+
+    auto topLayout = new QFormLayout;
+    topLayout->addRow(m_activeFpsChecked, limitLayout(m_activeFpsMode, m_activeFps));
+    if (x11ActiveWindow->isOk())
+    {
+        topLayout->addRow(m_windowedFpsChecked, limitLayout(m_windowedFpsMode, m_windowedFps));
+        topLayout->addRow(m_inactiveFpsChecked, limitLayout(m_inactiveFpsMode, m_inactiveFps));
+        topLayout->addRow(m_hiddenFpsChecked, limitLayout(m_hiddenFpsMode, m_hiddenFps));
+    }
+    else
+    {
+        hideWidgets({m_windowedFpsChecked, m_windowedFpsMode, m_windowedFps});
+        hideWidgets({m_inactiveFpsChecked, m_inactiveFpsMode, m_inactiveFps});
+        hideWidgets({m_hiddenFpsChecked, m_hiddenFpsMode, m_hiddenFps});
+    }
+    if (x11IdleMonitor->isOk())
+    {
+        topLayout->addRow(m_idleFpsChecked, limitLayout(m_idleFpsMode, m_idleFps));
+        topLayout->addRow("Idle after", m_idleTimeout);
+    }
+    else
+    {
+        hideWidgets({m_idleFpsChecked, m_idleFpsMode, m_idleFps, m_idleTimeout});
+    }
+    if (powerSupply->isOk())
+    {
+        topLayout->addRow(m_batteryFpsChecked, limitLayout(m_batteryFpsMode, m_batteryFps));
+        topLayout->addRow("Battery curve", m_batteryCurve);
+    }
+    else
+    {
+        hideWidgets({m_batteryFpsChecked, m_batteryFpsMode, m_batteryFps, m_batteryCurve});
+    }
+    if (thermalSource->isOk())
+    {
+        topLayout->addRow(m_thermalChecked, m_thermalCeiling);
+    }
+    else
+    {
+        hideWidgets({m_thermalChecked, m_thermalCeiling});
+    }
+
+    auto bottomLayout = new QGridLayout;
+    bottomLayout->addWidget(hLine, 0, 0, 1, 3);
+    bottomLayout->addWidget(new QLabel("Available applications"), 1, 0, 1, 1);
+    bottomLayout->addWidget(m_appSettingsWidget, 1, 1, 1, 1);
+    bottomLayout->addWidget(m_refresh, 1, 2, 1, 1);
+    bottomLayout->addWidget(m_appsList, 2, 0, 1, 3);
+
+    auto mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(topLayout);
+    mainLayout->addLayout(bottomLayout);
+
+    connect(externalControl, &ExternalControl::applicationAdded,
+            this, &SettingsWidget::addAppItem);
+    connect(externalControl, &ExternalControl::applicationRemoved,
+            this, &SettingsWidget::removeAppItem);
+
+    // Applied right away, the states could change before the widgets were created
+    auto updateIdleState = [=] {
+        auto font = m_idleFpsChecked->font();
+        font.setBold(x11IdleMonitor->isIdle());
+        m_idleFpsChecked->setFont(font);
+    };
+    auto updatePowerSource = [=] {
+        auto font = m_batteryFpsChecked->font();
+        font.setBold(powerSupply->isBattery());
+        m_batteryFpsChecked->setFont(font);
+    };
+    auto updateBatteryState = [=] {
+        if (powerSupply->capacity() > -1)
+            m_batteryFpsChecked->setToolTip(QString("Battery: %1% (%2)").arg(powerSupply->capacity()).arg(QString(powerSupply->status())));
+        else
+            m_batteryFpsChecked->setToolTip(QString());
+    };
+    auto updateThermalScale = [=] {
+        auto font = m_thermalChecked->font();
+        font.setBold(thermalSource->scale() < 1.0);
+        m_thermalChecked->setFont(font);
+    };
+    connect(x11IdleMonitor, &X11IdleMonitor::idleChanged,
+            this, updateIdleState);
+    connect(powerSupply, &PowerSupply::powerSourceChanged,
+            this, updatePowerSource);
+    connect(powerSupply, &PowerSupply::batteryStateChanged,
+            this, updateBatteryState);
+    connect(thermalSource, &ThermalSource::scaleChanged,
+            this, updateThermalScale);
+    updateIdleState();
+    updatePowerSource();
+    updateBatteryState();
+    updateThermalScale();
+
+    connect(m_policy, &FpsPolicy::appSettingsChanged,
+            this, &SettingsWidget::appsListSelectionChanged);
+
+    connect(m_activeFpsChecked, &QCheckBox::toggled,
+            m_activeFpsMode, &QComboBox::setEnabled);
+    connect(m_activeFpsChecked, &QCheckBox::toggled,
+            m_activeFps, &QDoubleSpinBox::setEnabled);
+    connect(m_windowedFpsChecked, &QCheckBox::toggled,
+            m_windowedFpsMode, &QComboBox::setEnabled);
+    connect(m_windowedFpsChecked, &QCheckBox::toggled,
+            m_windowedFps, &QDoubleSpinBox::setEnabled);
+    connect(m_inactiveFpsChecked, &QCheckBox::toggled,
+            m_inactiveFpsMode, &QComboBox::setEnabled);
+    connect(m_inactiveFpsChecked, &QCheckBox::toggled,
+            m_inactiveFps, &QDoubleSpinBox::setEnabled);
+    connect(m_hiddenFpsChecked, &QCheckBox::toggled,
+            m_hiddenFpsMode, &QComboBox::setEnabled);
+    connect(m_hiddenFpsChecked, &QCheckBox::toggled,
+            m_hiddenFps, &QDoubleSpinBox::setEnabled);
+    connect(m_idleFpsChecked, &QCheckBox::toggled,
+            m_idleFpsMode, &QComboBox::setEnabled);
+    connect(m_idleFpsChecked, &QCheckBox::toggled,
+            m_idleFps, &QDoubleSpinBox::setEnabled);
+    connect(m_idleFpsChecked, &QCheckBox::toggled,
+            m_idleTimeout, &QSpinBox::setEnabled);
+    connect(m_batteryFpsChecked, &QCheckBox::toggled,
+            m_batteryFpsMode, &QComboBox::setEnabled);
+    connect(m_batteryFpsChecked, &QCheckBox::toggled,
+            m_batteryFps, &QDoubleSpinBox::setEnabled);
+    connect(m_batteryFpsChecked, &QCheckBox::toggled,
+            m_batteryCurve, &QLineEdit::setEnabled);
+    connect(m_thermalChecked, &QCheckBox::toggled,
+            m_thermalCeiling, &QDoubleSpinBox::setEnabled);
+
+    connect(m_refresh, &QToolButton::clicked,
+            externalControl, &ExternalControl::refresh);
+
+    auto connectLimit = [this](FpsPolicy::Tier tier, QCheckBox *checkBox, QComboBox *comboBox, QDoubleSpinBox *spinBox) {
+        auto setLimit = [=] {
+            const auto mode = static_cast<FpsPolicy::LimitMode>(comboBox->currentIndex());
+            m_policy->setLimit(tier, {checkBox->isChecked(), spinBox->value(), mode});
+        };
+        connect(checkBox, &QCheckBox::toggled,
+                this, setLimit);
+        connect(comboBox, qOverload<int>(&QComboBox::currentIndexChanged),
+                this, [=](int index) {
+            QSignalBlocker blocker(spinBox);
+            setFpsSpinBoxMode(spinBox, static_cast<FpsPolicy::LimitMode>(index));
+            setLimit();
+        });
+        connect(spinBox, qOverload<double>(&QDoubleSpinBox::valueChanged),
+                this, setLimit);
+    };
+    connectLimit(FpsPolicy::ActiveTier, m_activeFpsChecked, m_activeFpsMode, m_activeFps);
+    connectLimit(FpsPolicy::WindowedTier, m_windowedFpsChecked, m_windowedFpsMode, m_windowedFps);
+    connectLimit(FpsPolicy::InactiveTier, m_inactiveFpsChecked, m_inactiveFpsMode, m_inactiveFps);
+    connectLimit(FpsPolicy::HiddenTier, m_hiddenFpsChecked, m_hiddenFpsMode, m_hiddenFps);
+    connectLimit(FpsPolicy::IdleTier, m_idleFpsChecked, m_idleFpsMode, m_idleFps);
+    connectLimit(FpsPolicy::BatteryTier, m_batteryFpsChecked, m_batteryFpsMode, m_batteryFps);
+
+    connect(m_batteryCurve, &QLineEdit::editingFinished,
+            this, [this] {
+        const auto batteryCurve = FpsPolicy::parseBatteryCurve(m_batteryCurve->text());
+        m_batteryCurve->setText(FpsPolicy::batteryCurveToString(batteryCurve));
+        m_policy->setBatteryCurve(batteryCurve);
+    });
+
+    connect(m_idleTimeout, qOverload<int>(&QSpinBox::valueChanged),
+            x11IdleMonitor, [=](int minutes) {
+        x11IdleMonitor->setTimeout(minutes * 60);
+    });
+
+    connect(m_thermalChecked, &QCheckBox::toggled,
+            thermalSource, &ThermalSource::setEnabled);
+    connect(m_thermalCeiling, qOverload<double>(&QDoubleSpinBox::valueChanged),
+            thermalSource, &ThermalSource::setCeiling);
+
+    connect(m_appsList->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &SettingsWidget::appsListSelectionChanged);
+
+    connect(m_appActiveEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_appActiveEnabled, &QCheckBox::toggled,
+            m_appActiveFps, &QDoubleSpinBox::setEnabled);
+    connect(m_appInactiveEnabled, &QCheckBox::toggled,
+            m_appInactiveFps, &QDoubleSpinBox::setEnabled);
+    connect(m_appBatteryEnabled, &QCheckBox::toggled,
+            m_appBatteryFps, &QDoubleSpinBox::setEnabled);
+    for (auto appFps : {m_appActiveFps, m_appInactiveFps, m_appBatteryFps})
+    {
+        connect(appFps, qOverload<double>(&QDoubleSpinBox::valueChanged),
+                this, &SettingsWidget::changeCurrAppSettings);
+    }
+    connect(m_appWindowedEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_appInactiveEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_appBatteryEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_appHiddenEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_appIdleEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_inactiveImmediateModeEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+    connect(m_bypassImmediateModeEnabled, &QCheckBox::toggled,
+            this, &SettingsWidget::changeCurrAppSettings);
+
+    updateAppsList();
+}
+SettingsWidget::~SettingsWidget()
+{
+}
+
+void SettingsWidget::updateAppItemToolTips()
+{
+    for (auto it = m_appItems.cbegin(), itEnd = m_appItems.cend(); it != itEnd; ++it)
+        updateAppItemToolTip(it.value());
+}
+
+inline QListWidgetItem *SettingsWidget::getSelectedItem() const
+{
+    return m_appsList->selectedItems().value(0);
+}
+
+void SettingsWidget::updateAppsList()
+{
+    for (auto &&app : m_policy->externalControl()->applications())
+        addAppItem(app);
+}
+
+void SettingsWidget::addAppItem(const ExternalControl::AppDescr &app)
+{
+    auto item = new QListWidgetItem(QString("%1 (%2)").arg(app.name).arg(app.pid));
+    item->setData(Qt::UserRole, app.nameId);
+    updateAppItemToolTip(item);
+
+    m_appsList->insertItem(0, item);
+    m_appItems[app.file] = item;
+}
+void SettingsWidget::updateAppItemToolTip(QListWidgetItem *item)
+{
+    const auto nameId = item->data(Qt::UserRole).toUInt();
+    const auto settingsId = m_policy->settingsId(nameId);
+    if (settingsId != nameId)
+        item->setToolTip(QString("Uses \"%1\" settings").arg(m_policy->externalControl()->name(settingsId)));
+    else
+        item->setToolTip(QString());
+}
+void SettingsWidget::removeAppItem(const ExternalControl::AppDescr &app)
+{
+    auto item = m_appItems.take(app.file);
+    if (!item)
+        return;
+
+    const bool wasSelected = item->isSelected();
+    delete item;
+
+    if (wasSelected)
+        appsListSelectionChanged();
+}
+
+void SettingsWidget::changeCurrAppSettings()
+{
+    auto item = getSelectedItem();
+    if (!item)
+        return;
+
+    const auto nameId = item->data(Qt::UserRole).toUInt();
+
+    auto settings = m_policy->appSettings(nameId);
+    settings.active = m_appActiveEnabled->isChecked();
+    settings.windowed = m_appWindowedEnabled->isChecked();
+    settings.inactive = m_appInactiveEnabled->isChecked();
+    settings.battery = m_appBatteryEnabled->isChecked();
+    settings.hidden = m_appHiddenEnabled->isChecked();
+    settings.idle = m_appIdleEnabled->isChecked();
+    settings.inactiveImmediateMode = m_inactiveImmediateModeEnabled->isChecked();
+    settings.bypassImmediateMode = m_bypassImmediateModeEnabled->isChecked();
+    settings.activeFps = m_appActiveFps->value();
+    settings.inactiveFps = m_appInactiveFps->value();
+    settings.batteryFps = m_appBatteryFps->value();
+    m_policy->setAppSettings(nameId, settings);
+}
+
+void SettingsWidget::appsListSelectionChanged()
+{
+    auto item = getSelectedItem();
+    if (!item)
+    {
+        m_appSettingsWidget->hide();
+        return;
+    }
+
+    QSignalBlocker blocker[] {
+        QSignalBlocker(m_appActiveEnabled),
+        QSignalBlocker(m_appWindowedEnabled),
+        QSignalBlocker(m_appInactiveEnabled),
+        QSignalBlocker(m_appBatteryEnabled),
+        QSignalBlocker(m_appHiddenEnabled),
+        QSignalBlocker(m_appIdleEnabled),
+        QSignalBlocker(m_inactiveImmediateModeEnabled),
+        QSignalBlocker(m_bypassImmediateModeEnabled),
+        QSignalBlocker(m_appActiveFps),
+        QSignalBlocker(m_appInactiveFps),
+        QSignalBlocker(m_appBatteryFps),
+    };
+
+    const auto settings = m_policy->appSettings(item->data(Qt::UserRole).toUInt());
+
+    m_appActiveEnabled->setChecked(settings.active);
+    m_appWindowedEnabled->setChecked(settings.windowed);
+    m_appInactiveEnabled->setChecked(settings.inactive);
+    m_appBatteryEnabled->setChecked(settings.battery);
+    m_appHiddenEnabled->setChecked(settings.hidden);
+    m_appIdleEnabled->setChecked(settings.idle);
+    m_inactiveImmediateModeEnabled->setChecked(settings.inactiveImmediateMode);
+    m_bypassImmediateModeEnabled->setChecked(settings.bypassImmediateMode);
+    m_appActiveFps->setValue(settings.activeFps);
+    m_appActiveFps->setEnabled(settings.active);
+    m_appInactiveFps->setValue(settings.inactiveFps);
+    m_appInactiveFps->setEnabled(settings.inactive);
+    m_appBatteryFps->setValue(settings.batteryFps);
+    m_appBatteryFps->setEnabled(settings.battery);
+
+    m_appSettingsWidget->show();
+}
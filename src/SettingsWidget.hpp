@@ -0,0 +1,115 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "ExternalControl.hpp"
+
+#include <QWidget>
+#include <QHash>
+
+class FpsPolicy;
+
+class QListWidgetItem;
+class QDoubleSpinBox;
+class QSpinBox;
+class QListWidget;
+class QToolButton;
+class QCheckBox;
+class QComboBox;
+class QLineEdit;
+
+// Limits and per-application settings, all changes are applied to the policy
+class SettingsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SettingsWidget(FpsPolicy *policy, QWidget *parent = nullptr);
+    ~SettingsWidget();
+
+    void updateAppItemToolTips();
+
+private:
+    inline QListWidgetItem *getSelectedItem() const;
+
+    void updateAppsList();
+    void addAppItem(const ExternalControl::AppDescr &app);
+    void updateAppItemToolTip(QListWidgetItem *item);
+    void removeAppItem(const ExternalControl::AppDescr &app);
+
+    void changeCurrAppSettings();
+
+    void appsListSelectionChanged();
+
+private:
+    FpsPolicy *const m_policy;
+
+    QCheckBox *const m_activeFpsChecked;
+    QComboBox *const m_activeFpsMode;
+    QDoubleSpinBox *const m_activeFps;
+
+    QCheckBox *const m_windowedFpsChecked;
+    QComboBox *const m_windowedFpsMode;
+    QDoubleSpinBox *const m_windowedFps;
+
+    QCheckBox *const m_inactiveFpsChecked;
+    QComboBox *const m_inactiveFpsMode;
+    QDoubleSpinBox *const m_inactiveFps;
+
+    QCheckBox *const m_hiddenFpsChecked;
+    QComboBox *const m_hiddenFpsMode;
+    QDoubleSpinBox *const m_hiddenFps;
+
+    QCheckBox *const m_idleFpsChecked;
+    QComboBox *const m_idleFpsMode;
+    QDoubleSpinBox *const m_idleFps;
+    QSpinBox *const m_idleTimeout;
+
+    QCheckBox *const m_batteryFpsChecked;
+    QComboBox *const m_batteryFpsMode;
+    QDoubleSpinBox *const m_batteryFps;
+    QLineEdit *const m_batteryCurve;
+
+    QCheckBox *const m_thermalChecked;
+    QDoubleSpinBox *const m_thermalCeiling;
+
+    QToolButton *const m_refresh;
+    QListWidget *const m_appsList;
+
+    QWidget *const m_appSettingsWidget;
+    QCheckBox *const m_appActiveEnabled;
+    QDoubleSpinBox *const m_appActiveFps;
+    QCheckBox *const m_appWindowedEnabled;
+    QCheckBox *const m_appInactiveEnabled;
+    QDoubleSpinBox *const m_appInactiveFps;
+    QCheckBox *const m_appBatteryEnabled;
+    QDoubleSpinBox *const m_appBatteryFps;
+    QCheckBox *const m_appHiddenEnabled;
+    QCheckBox *const m_appIdleEnabled;
+    QCheckBox *const m_inactiveImmediateModeEnabled;
+    QCheckBox *const m_bypassImmediateModeEnabled;
+
+    QHash<QString, QListWidgetItem *> m_appItems;
+};
@@ -0,0 +1,97 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "AppRules.hpp"
+
+#include <QDebug>
+
+using namespace std;
+
+vector<AppRules::Rule> AppRules::defaultRules()
+{
+    Rule explorer;
+    explorer.pattern = "explorer.exe";
+    explorer.ignore = true;
+    return {explorer};
+}
+
+QString AppRules::syntaxToString(Syntax syntax)
+{
+    return (syntax == RegexSyntax) ? "Regex" : "Glob";
+}
+AppRules::Syntax AppRules::syntaxFromString(const QString &str)
+{
+    return (str == "Regex") ? RegexSyntax : GlobSyntax;
+}
+
+QRegularExpression AppRules::compile(const Rule &rule)
+{
+    if (rule.pattern.isEmpty())
+        return QRegularExpression();
+
+    const QRegularExpression expression(
+        (rule.syntax == RegexSyntax)
+            ? QRegularExpression::anchoredPattern(rule.pattern)
+            : QRegularExpression::wildcardToRegularExpression(rule.pattern)
+    );
+    if (!expression.isValid())
+        return QRegularExpression();
+
+    return expression;
+}
+
+AppRules::AppRules()
+{
+}
+AppRules::~AppRules()
+{
+}
+
+void AppRules::setRules(const vector<Rule> &rules)
+{
+    m_rules = rules;
+
+    m_expressions.clear();
+    m_expressions.reserve(m_rules.size());
+    for (auto &&rule : m_rules)
+    {
+        auto expression = compile(rule);
+        if (expression.pattern().isEmpty())
+            qWarning() << "Invalid application rule:" << rule.pattern;
+        else
+            expression.optimize();
+        m_expressions.push_back(move(expression));
+    }
+}
+
+int AppRules::match(const QString &name) const
+{
+    for (size_t i = 0; i < m_expressions.size(); ++i)
+    {
+        const auto &expression = m_expressions[i];
+        if (!expression.pattern().isEmpty() && expression.match(name).hasMatch())
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,78 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <QRegularExpression>
+#include <QString>
+
+#include <vector>
+
+// Ordered application name rules, the first matching rule wins
+class AppRules
+{
+public:
+    enum Syntax
+    {
+        GlobSyntax,
+        RegexSyntax,
+    };
+
+    struct Rule
+    {
+        Syntax syntax = GlobSyntax;
+        QString pattern; // Matches the whole application name
+        QString profile; // Settings of this name are used
+        bool ignore = false; // The application is not controlled at all
+    };
+
+public:
+    static std::vector<Rule> defaultRules();
+
+    static QString syntaxToString(Syntax syntax);
+    static Syntax syntaxFromString(const QString &str);
+
+    // Returns an empty expression for an empty or invalid pattern
+    static QRegularExpression compile(const Rule &rule);
+
+    AppRules();
+    ~AppRules();
+
+    inline const std::vector<Rule> &rules() const;
+    void setRules(const std::vector<Rule> &rules);
+
+    // Index of the first matching rule, -1 if nothing matches
+    int match(const QString &name) const;
+
+private:
+    std::vector<Rule> m_rules;
+    std::vector<QRegularExpression> m_expressions;
+};
+
+/* Inline implementation */
+
+const std::vector<AppRules::Rule> &AppRules::rules() const
+{
+    return m_rules;
+}
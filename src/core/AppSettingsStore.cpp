@@ -0,0 +1,268 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "AppSettingsStore.hpp"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QDebug>
+#include <QFile>
+
+using namespace std;
+
+static constexpr quint32 s_magic = 0x564c4653; // "VLFS"
+static constexpr quint16 s_version = 1;
+static constexpr auto s_streamVersion = QDataStream::Qt_5_12;
+
+enum RecordType : quint8
+{
+    PutRecord = 1,
+};
+
+AppSettingsStore::AppSettingsStore(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+AppSettingsStore::~AppSettingsStore()
+{
+    if (!m_writer.joinable())
+        return;
+
+    {
+        lock_guard<mutex> locker(m_mutex);
+        m_quit = true;
+    }
+    m_jobsCond.notify_one();
+    m_writer.join();
+}
+
+bool AppSettingsStore::exists() const
+{
+    return QFile::exists(m_filePath);
+}
+
+vector<AppSettingsStore::Entry> AppSettingsStore::load()
+{
+    flush();
+
+    m_entries.clear();
+    m_appendedRecords = 0;
+    m_needsCompaction = false;
+
+    QFile file(m_filePath);
+    if (!file.open(QFile::ReadOnly))
+        return {};
+
+    const auto data = file.readAll();
+    file.close();
+
+    QDataStream stream(data);
+    stream.setVersion(s_streamVersion);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version)
+    {
+        qWarning() << "Unsupported application settings file:" << m_filePath;
+        m_needsCompaction = true;
+        return {};
+    }
+
+    while (!stream.atEnd())
+    {
+        quint8 type = 0;
+        Entry entry;
+        stream >> type >> entry.name;
+        if (type == PutRecord)
+            stream >> entry.flags >> entry.activeFps >> entry.inactiveFps >> entry.batteryFps >> entry.lastUsed;
+
+        if (stream.status() != QDataStream::Ok || type != PutRecord)
+        {
+            // E.g. interrupted append, records written after it couldn't be read
+            qWarning() << "Truncated application settings file:" << m_filePath;
+            m_needsCompaction = true;
+            break;
+        }
+
+        if (m_entries.contains(entry.name))
+            ++m_appendedRecords;
+        m_entries[entry.name] = entry;
+    }
+
+    vector<Entry> entries;
+    entries.reserve(m_entries.size());
+    for (auto &&entry : m_entries)
+        entries.push_back(entry);
+    return entries;
+}
+
+void AppSettingsStore::setWritable(bool writable)
+{
+    m_writable = writable;
+    if (m_writable && m_needsCompaction)
+        compactMirror();
+}
+
+void AppSettingsStore::put(const Entry &entry)
+{
+    if (!m_writable)
+        return;
+
+    m_entries[entry.name] = entry;
+
+    if (m_needsCompaction || ++m_appendedRecords > qMax(s_minCompactionRecords, static_cast<int>(m_entries.size())))
+    {
+        compactMirror();
+        return;
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(s_streamVersion);
+    writeEntry(stream, entry);
+
+    enqueue({data, false});
+}
+void AppSettingsStore::compact(const vector<Entry> &entries)
+{
+    if (!m_writable)
+        return;
+
+    m_entries.clear();
+    for (auto &&entry : entries)
+        m_entries[entry.name] = entry;
+
+    compactMirror();
+}
+
+bool AppSettingsStore::flush()
+{
+    unique_lock<mutex> locker(m_mutex);
+    m_idleCond.wait(locker, [this] {
+        return (m_jobs.empty() && !m_writing);
+    });
+
+    const bool ok = !m_failed;
+    m_failed = false;
+    return ok;
+}
+
+QByteArray AppSettingsStore::header()
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(s_streamVersion);
+    stream << s_magic << s_version;
+    return data;
+}
+void AppSettingsStore::writeEntry(QDataStream &stream, const Entry &entry)
+{
+    stream << static_cast<quint8>(PutRecord) << entry.name;
+    stream << entry.flags << entry.activeFps << entry.inactiveFps << entry.batteryFps << entry.lastUsed;
+}
+
+void AppSettingsStore::compactMirror()
+{
+    auto data = header();
+    {
+        QDataStream stream(&data, QIODevice::Append);
+        stream.setVersion(s_streamVersion);
+        for (auto &&entry : m_entries)
+            writeEntry(stream, entry);
+    }
+
+    m_appendedRecords = 0;
+    m_needsCompaction = false;
+
+    enqueue({data, true});
+}
+
+void AppSettingsStore::enqueue(Job &&job)
+{
+    {
+        lock_guard<mutex> locker(m_mutex);
+
+        // A replacement makes the queued writes redundant
+        if (job.replace)
+            m_jobs.clear();
+        m_jobs.push_back(move(job));
+    }
+    m_jobsCond.notify_one();
+
+    if (!m_writer.joinable())
+        m_writer = thread(&AppSettingsStore::writerLoop, this);
+}
+void AppSettingsStore::writerLoop()
+{
+    unique_lock<mutex> locker(m_mutex);
+    for (;;)
+    {
+        m_jobsCond.wait(locker, [this] {
+            return (m_quit || !m_jobs.empty());
+        });
+        if (m_jobs.empty())
+            break; // Quit only when everything is written
+
+        const auto job = move(m_jobs.front());
+        m_jobs.pop_front();
+        m_writing = true;
+
+        locker.unlock();
+        const bool ok = write(job);
+        locker.lock();
+
+        m_writing = false;
+        if (!ok)
+            m_failed = true;
+        if (m_jobs.empty())
+            m_idleCond.notify_all();
+    }
+}
+bool AppSettingsStore::write(const Job &job)
+{
+    if (job.replace)
+    {
+        QSaveFile file(m_filePath);
+        if (!file.open(QFile::WriteOnly) || file.write(job.data) != job.data.size() || !file.commit())
+        {
+            qWarning() << "Unable to write application settings:" << m_filePath;
+            return false;
+        }
+        return true;
+    }
+
+    QFile file(m_filePath);
+    if (!file.open(QFile::WriteOnly | QFile::Append))
+    {
+        qWarning() << "Unable to append application settings:" << m_filePath;
+        return false;
+    }
+
+    const auto data = (file.size() == 0)
+        ? header() + job.data
+        : job.data
+    ;
+    return (file.write(data) == data.size());
+}
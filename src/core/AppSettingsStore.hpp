@@ -0,0 +1,120 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <QString>
+#include <QHash>
+
+#include <condition_variable>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+class QDataStream;
+
+// Binary per-application settings: a snapshot followed by appended records,
+// loaded with a single read. Writes are done on a writer thread.
+class AppSettingsStore
+{
+    static constexpr int s_minCompactionRecords = 64;
+
+public:
+    struct Entry
+    {
+        QString name;
+        quint16 flags = 0; // Opaque for the store
+        double activeFps = 0.0;
+        double inactiveFps = 0.0;
+        double batteryFps = 0.0;
+        qint64 lastUsed = 0; // Seconds since epoch
+    };
+
+public:
+    AppSettingsStore(const QString &filePath);
+    ~AppSettingsStore();
+
+    inline QString filePath() const;
+    bool exists() const;
+
+    // Later records replace earlier ones, a truncated record ends the file
+    std::vector<Entry> load();
+
+    inline bool isWritable() const;
+    void setWritable(bool writable);
+
+    // Appends the entry, the file is compacted when enough records are appended
+    void put(const Entry &entry);
+    // Replaces the file contents
+    void compact(const std::vector<Entry> &entries);
+
+    // Waits for the queued writes, returns false if any of them failed
+    bool flush();
+
+private:
+    struct Job
+    {
+        QByteArray data;
+        bool replace = false;
+    };
+
+    static QByteArray header();
+    static void writeEntry(QDataStream &stream, const Entry &entry);
+
+    void compactMirror();
+
+    void enqueue(Job &&job);
+    void writerLoop();
+    bool write(const Job &job);
+
+private:
+    const QString m_filePath;
+    bool m_writable = false;
+
+    QHash<QString, Entry> m_entries; // Mirror of the file contents
+    int m_appendedRecords = 0;
+    bool m_needsCompaction = false;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_jobsCond;
+    std::condition_variable m_idleCond;
+    std::deque<Job> m_jobs;
+    bool m_writing = false;
+    bool m_failed = false;
+    bool m_quit = false;
+};
+
+/* Inline implementation */
+
+QString AppSettingsStore::filePath() const
+{
+    return m_filePath;
+}
+
+bool AppSettingsStore::isWritable() const
+{
+    return m_writable;
+}
@@ -0,0 +1,589 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "ExternalControl.hpp"
+
+#include <QSocketNotifier>
+#include <QDebug>
+#include <QTimer>
+#include <QSet>
+
+#include <filesystem>
+#include <algorithm>
+
+#include <cerrno>
+
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <signal.h>
+#include <fcntl.h>
+
+#ifndef SYS_pidfd_open
+#   define SYS_pidfd_open 434
+#endif
+
+using namespace std;
+
+static bool isProcessAlive(qint64 pid)
+{
+    return (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+static int pidfdOpen(qint64 pid)
+{
+    return syscall(SYS_pidfd_open, pid, 0);
+}
+
+ExternalControl::ExternalControl()
+    : m_flimesDir(QString::fromStdString(filesystem::temp_directory_path().concat("/vk-layer-flimes")))
+    , m_flimesPlaceholderFile(m_flimesDir.path() + "/PLACEHOLDER")
+{
+    // Descriptors are kept open, so a vanished reader must result in EPIPE instead of killing us
+    signal(SIGPIPE, SIG_IGN);
+
+    m_flimesDir.mkpath(".");
+    m_flimesPlaceholderFile.open(QFile::WriteOnly);
+
+    m_retryClock.start();
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout,
+            this, &ExternalControl::retryPending);
+
+#ifdef USE_IO_URING
+    m_ioUring = make_unique<IoUring>(64);
+    if (m_ioUring->isOk())
+    {
+        connect(m_ioUring.get(), &IoUring::writeCompleted,
+                this, &ExternalControl::writeCompleted);
+    }
+    else
+    {
+        qDebug() << "io_uring is not available, using synchronous writes";
+        m_ioUring.reset();
+    }
+#endif
+
+    if (!m_watcher.addPath(m_flimesDir.path()))
+        return;
+
+    connect(&m_watcher, &InotifyWatcher::filesChanged,
+            this, &ExternalControl::dirEntriesChanged);
+    connect(&m_watcher, &InotifyWatcher::overflowed,
+            this, &ExternalControl::watchDirLost);
+
+    refresh();
+
+    m_ok = true;
+}
+ExternalControl::~ExternalControl()
+{
+    cleanup();
+}
+
+void ExternalControl::cleanup()
+{
+    if (m_cleanupDone)
+        return;
+
+#ifdef USE_IO_URING
+    if (m_ioUring)
+        m_ioUring->waitForCompletions();
+#endif
+
+    m_retryTimer.stop();
+
+    for (auto &&appDescr : m_applications)
+    {
+        closeFifo(appDescr);
+        closeExitNotifier(appDescr);
+    }
+
+    m_flimesPlaceholderFile.remove();
+    m_flimesDir.rmdir("../" + m_flimesDir.dirName());
+
+    m_cleanupDone = true;
+}
+
+bool ExternalControl::setData(AppDescr &appDescr, double fps, const optional<bool> &forceImmediate)
+{
+    // Only the latest command matters, it replaces any pending one
+    appDescr.requested = {fps, forceImmediate};
+    appDescr.pending = false;
+
+    if (writeRequested(appDescr))
+        return true;
+
+    writeFailed(appDescr, errno);
+    return false;
+}
+
+void ExternalControl::commit()
+{
+#ifdef USE_IO_URING
+    if (m_ioUring)
+        m_ioUring->submit();
+#endif
+}
+
+void ExternalControl::refresh()
+{
+    dirContentsChanged(m_flimesDir.path());
+}
+
+void ExternalControl::setAppFilter(const AppFilterFn &appFilter)
+{
+    m_appFilter = appFilter;
+
+    bool released = false;
+    for (auto &&appDescr : m_applications)
+    {
+        if (!m_appFilter || m_appFilter(appDescr.nameId))
+            continue;
+
+        const bool sentForceImmediate = appDescr.sentForceImmediate.value_or(false);
+        if (appDescr.sentFps.value_or(0.0) != 0.0 || sentForceImmediate)
+        {
+            setData(appDescr, 0.0, sentForceImmediate ? optional<bool>(false) : nullopt);
+            released = true;
+        }
+    }
+    if (released)
+    {
+        commit();
+#ifdef USE_IO_URING
+        if (m_ioUring)
+            m_ioUring->waitForCompletions();
+#endif
+    }
+
+    bool changed = false;
+    for (size_t i = m_applications.size(); i-- > 0;)
+    {
+        if (m_appFilter && !m_appFilter(m_applications[i].nameId))
+        {
+            removeApplication(i);
+            changed = true;
+        }
+    }
+    if (changed)
+        emit applicationsChanged();
+
+    // Adds the applications rejected by the previous filter
+    if (m_ok)
+        refresh();
+}
+
+quint32 ExternalControl::nameId(const QString &name)
+{
+    auto it = m_nameIds.constFind(name);
+    if (it != m_nameIds.constEnd())
+        return it.value();
+
+    const quint32 id = m_names.size();
+    m_nameIds.insert(name, id);
+    m_names.push_back(name);
+    return id;
+}
+
+void ExternalControl::watchDirLost()
+{
+    // Recreates the directory if it has been removed, a moved one must not be watched anymore
+    m_watcher.removePath(m_flimesDir.path());
+    if (!m_flimesPlaceholderFile.exists())
+    {
+        m_flimesDir.mkpath(".");
+        m_flimesPlaceholderFile.close();
+        m_flimesPlaceholderFile.open(QFile::WriteOnly);
+    }
+    if (!m_watcher.addPath(m_flimesDir.path()))
+        qWarning() << "Unable to watch" << m_flimesDir.path();
+
+    refresh();
+}
+
+void ExternalControl::dirContentsChanged(const QString &path)
+{
+    Q_ASSERT(path == m_flimesDir.path());
+
+    auto dir = opendir(QFile::encodeName(path).constData());
+    if (!dir)
+        return;
+
+    QSet<QString> fifos;
+    while (auto entry = readdir(dir))
+    {
+        if (entry->d_type == DT_UNKNOWN)
+        {
+            struct stat st;
+            if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISFIFO(st.st_mode))
+                continue;
+        }
+        else if (entry->d_type != DT_FIFO)
+        {
+            continue;
+        }
+        fifos.insert(path + "/" + QFile::decodeName(entry->d_name));
+    }
+    closedir(dir);
+
+    bool changed = false;
+
+    for (size_t i = m_applications.size(); i-- > 0;)
+    {
+        const auto &appDescr = m_applications[i];
+
+        // Without pidfd support the process liveness can be checked only here
+        const bool exists = fifos.remove(appDescr.file);
+        if (exists && (appDescr.exitNotifier || isProcessAlive(appDescr.pid)))
+            continue;
+
+        if (exists)
+        {
+            qDebug() << "Deleting:" << appDescr.file;
+            QFile::remove(appDescr.file);
+        }
+
+        removeApplication(i);
+        changed = true;
+    }
+
+    for (auto &&filePath : fifos)
+        changed |= addApplication(filePath);
+
+    if (changed)
+        emit applicationsChanged();
+}
+void ExternalControl::dirEntriesChanged(const QStringList &created, const QStringList &removed)
+{
+    const auto dirPath = m_flimesDir.path() + "/";
+
+    bool changed = false;
+
+    for (auto &&fileName : removed)
+    {
+        const auto idx = m_appIndices.value(dirPath + fileName, m_applications.size());
+        if (idx < m_applications.size())
+        {
+            removeApplication(idx);
+            changed = true;
+        }
+    }
+
+    for (auto &&fileName : created)
+    {
+        const auto filePath = dirPath + fileName;
+
+        struct stat st;
+        if (lstat(QFile::encodeName(filePath).constData(), &st) != 0 || !S_ISFIFO(st.st_mode))
+            continue;
+
+        if (!m_appIndices.contains(filePath))
+            changed |= addApplication(filePath);
+    }
+
+    if (changed)
+        emit applicationsChanged();
+}
+
+bool ExternalControl::addApplication(const QString &filePath)
+{
+    const auto filename = filePath.mid(filePath.lastIndexOf("/") + 1);
+
+    const int dashIdx = filename.lastIndexOf("-");
+    if (dashIdx < 1)
+        return false;
+
+    bool ok = false;
+
+    AppDescr appDescr;
+    appDescr.file = filePath;
+    appDescr.name = filename.left(dashIdx);
+    appDescr.pid = filename.mid(dashIdx + 1).toLongLong(&ok);
+
+    if (!ok)
+        return false;
+
+    const int pidfd = pidfdOpen(appDescr.pid);
+    if (pidfd < 0 && (errno == ESRCH || !isProcessAlive(appDescr.pid)))
+    {
+        qDebug() << "Deleting:" << appDescr.file;
+        QFile::remove(appDescr.file);
+        return false;
+    }
+
+    appDescr.nameId = nameId(appDescr.name);
+
+    if (m_appFilter && !m_appFilter(appDescr.nameId))
+    {
+        if (pidfd > -1)
+            close(pidfd);
+        return false;
+    }
+
+    if (pidfd > -1)
+    {
+        auto exitNotifier = new QSocketNotifier(pidfd, QSocketNotifier::Read, this);
+        connect(exitNotifier, &QSocketNotifier::activated,
+                this, [=] {
+            processExited(filePath);
+        });
+        appDescr.exitNotifier = exitNotifier;
+    }
+
+    m_appIndices[filePath] = m_applications.size();
+    m_applications.push_back(move(appDescr));
+    emit applicationAdded(m_applications.back());
+
+    return true;
+}
+void ExternalControl::removeApplication(size_t idx)
+{
+    auto &appDescr = m_applications[idx];
+
+    emit applicationRemoved(appDescr);
+
+    closeFifo(appDescr);
+    closeExitNotifier(appDescr);
+
+    m_appIndices.remove(appDescr.file);
+    if (idx != m_applications.size() - 1)
+    {
+        appDescr = move(m_applications.back());
+        m_appIndices[appDescr.file] = idx;
+    }
+    m_applications.pop_back();
+}
+
+void ExternalControl::processExited(const QString &filePath)
+{
+    const auto idx = m_appIndices.value(filePath, m_applications.size());
+    if (idx >= m_applications.size())
+        return;
+
+    qDebug() << "Deleting:" << filePath;
+    QFile::remove(filePath);
+
+    removeApplication(idx);
+
+    emit applicationsChanged();
+}
+
+bool ExternalControl::writeRequested(AppDescr &appDescr)
+{
+    const auto &command = appDescr.requested;
+
+    QByteArray data;
+    if (appDescr.sentFps != command.fps)
+        data += QByteArray::number(command.fps, 'f', 3) + "\n";
+    if (command.forceImmediate.has_value() && appDescr.sentForceImmediate != command.forceImmediate)
+        data += command.forceImmediate.value() ? "IMMEDIATE\n" : "AUTO\n";
+
+    if (data.isEmpty())
+        return true;
+
+    if (appDescr.fd < 0)
+    {
+        appDescr.fd = open(appDescr.file.toLocal8Bit().constData(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (appDescr.fd < 0)
+            return false;
+    }
+
+    bool queued = false;
+#ifdef USE_IO_URING
+    if (m_ioUring)
+    {
+        queued = m_ioUring->queueWrite(appDescr.fd, data, m_ioUringSeq);
+        if (!queued && m_ioUring->submit())
+            queued = m_ioUring->queueWrite(appDescr.fd, data, m_ioUringSeq);
+        if (!queued)
+        {
+            // A synchronous write could overtake the queued ones, retry later instead
+            errno = EBUSY;
+            return false;
+        }
+        m_ioUringWrites.insert(m_ioUringSeq++, {appDescr.file, data.size()});
+    }
+#endif
+
+    // Queued writes are assumed to succeed, "writeFailed()" reverts it otherwise
+    if (!queued)
+    {
+        const ssize_t written = write(appDescr.fd, data.constData(), data.size());
+        if (written < 0)
+            return false;
+        if (written < data.size())
+        {
+            // Short write, the whole command is sent again when writable
+            errno = EAGAIN;
+            return false;
+        }
+    }
+
+    appDescr.sentFps = command.fps;
+    if (command.forceImmediate.has_value())
+        appDescr.sentForceImmediate = command.forceImmediate;
+    appDescr.retryDelay = 0;
+    return true;
+}
+
+void ExternalControl::writeFailed(AppDescr &appDescr, int err)
+{
+    if (err == EPIPE)
+    {
+        // The reader went away, the application has probably exited
+        closeFifo(appDescr);
+        QTimer::singleShot(0, this, &ExternalControl::refresh);
+    }
+    else
+    {
+        appDescr.sentFps.reset();
+        appDescr.sentForceImmediate.reset();
+    }
+
+    appDescr.pending = true;
+
+    if (err == EAGAIN && appDescr.fd > -1)
+        waitForWritable(appDescr);
+    else
+        scheduleRetry(appDescr);
+}
+
+void ExternalControl::waitForWritable(AppDescr &appDescr)
+{
+    if (!appDescr.writeNotifier)
+    {
+        const auto filePath = appDescr.file;
+        appDescr.writeNotifier = new QSocketNotifier(appDescr.fd, QSocketNotifier::Write, this);
+        connect(appDescr.writeNotifier, &QSocketNotifier::activated,
+                this, [=] {
+            fifoWritable(filePath);
+        });
+    }
+    appDescr.writeNotifier->setEnabled(true);
+}
+void ExternalControl::fifoWritable(const QString &filePath)
+{
+    const auto idx = m_appIndices.value(filePath, m_applications.size());
+    if (idx >= m_applications.size())
+        return;
+
+    auto &appDescr = m_applications[idx];
+    appDescr.writeNotifier->setEnabled(false);
+    if (!appDescr.pending)
+        return;
+
+    retryWrite(appDescr);
+    commit();
+}
+
+void ExternalControl::scheduleRetry(AppDescr &appDescr)
+{
+    appDescr.retryDelay = appDescr.retryDelay > 0
+        ? min(appDescr.retryDelay * 2, s_maxRetryDelay)
+        : s_minRetryDelay
+    ;
+    appDescr.retryAt = m_retryClock.elapsed() + appDescr.retryDelay;
+
+    const int remainingTime = m_retryTimer.remainingTime();
+    if (remainingTime < 0 || remainingTime > appDescr.retryDelay)
+        m_retryTimer.start(appDescr.retryDelay);
+}
+void ExternalControl::retryPending()
+{
+    const qint64 now = m_retryClock.elapsed();
+    for (auto &&appDescr : m_applications)
+    {
+        if (!appDescr.pending || appDescr.retryAt > now)
+            continue;
+        if (appDescr.writeNotifier && appDescr.writeNotifier->isEnabled())
+            continue;
+        retryWrite(appDescr);
+    }
+    commit();
+
+    qint64 nextRetryAt = -1;
+    for (auto &&appDescr : m_applications)
+    {
+        if (!appDescr.pending || (appDescr.writeNotifier && appDescr.writeNotifier->isEnabled()))
+            continue;
+        if (nextRetryAt < 0 || appDescr.retryAt < nextRetryAt)
+            nextRetryAt = appDescr.retryAt;
+    }
+    if (nextRetryAt > -1)
+        m_retryTimer.start(max<qint64>(nextRetryAt - m_retryClock.elapsed(), 0));
+}
+void ExternalControl::retryWrite(AppDescr &appDescr)
+{
+    appDescr.pending = false;
+    if (!writeRequested(appDescr))
+        writeFailed(appDescr, errno);
+}
+#ifdef USE_IO_URING
+void ExternalControl::writeCompleted(quint64 userData, int result)
+{
+    const auto write = m_ioUringWrites.take(userData);
+    if (result >= write.second)
+        return;
+
+    // Short and empty writes are retried when writable, like EAGAIN
+    const auto idx = m_appIndices.value(write.first, m_applications.size());
+    if (idx < m_applications.size())
+        writeFailed(m_applications[idx], (result < 0) ? -result : EAGAIN);
+}
+#endif
+
+void ExternalControl::closeFifo(AppDescr &appDescr)
+{
+    if (appDescr.fd < 0)
+        return;
+
+    // Queued writes can refer to this descriptor
+    commit();
+
+    if (appDescr.writeNotifier)
+    {
+        appDescr.writeNotifier->setEnabled(false);
+        appDescr.writeNotifier->deleteLater();
+        appDescr.writeNotifier = nullptr;
+    }
+
+    close(appDescr.fd);
+    appDescr.fd = -1;
+
+    // The reader state is unknown from now on
+    appDescr.sentFps.reset();
+    appDescr.sentForceImmediate.reset();
+}
+void ExternalControl::closeExitNotifier(AppDescr &appDescr)
+{
+    if (!appDescr.exitNotifier)
+        return;
+
+    appDescr.exitNotifier->setEnabled(false);
+    close(appDescr.exitNotifier->socket());
+    appDescr.exitNotifier->deleteLater();
+    appDescr.exitNotifier = nullptr;
+}
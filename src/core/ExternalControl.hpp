@@ -0,0 +1,198 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "InotifyWatcher.hpp"
+#ifdef USE_IO_URING
+#   include "IoUring.hpp"
+#endif
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFile>
+#include <QHash>
+#include <QDir>
+
+#include <functional>
+#include <optional>
+#include <memory>
+
+class QSocketNotifier;
+
+class ExternalControl : public QObject
+{
+    Q_OBJECT
+
+    static constexpr int s_minRetryDelay = 50;
+    static constexpr int s_maxRetryDelay = 5000;
+
+public:
+    struct Command
+    {
+        double fps = 0.0;
+        std::optional<bool> forceImmediate;
+    };
+
+    struct AppDescr
+    {
+        QString file;
+        QString name;
+        quint32 nameId = 0; // Interned "name", see "ExternalControl::nameId()"
+        qint64 pid = 0;
+
+        int fd = -1; // Kept open for the application lifetime
+
+        // Last values written to the FIFO, used to skip redundant writes
+        std::optional<double> sentFps;
+        std::optional<bool> sentForceImmediate;
+
+        // Latest command, retried until written if it couldn't be written right away
+        Command requested;
+        bool pending = false;
+        int retryDelay = 0;
+        qint64 retryAt = 0;
+        QSocketNotifier *writeNotifier = nullptr;
+
+        QSocketNotifier *exitNotifier = nullptr; // Watches the process pidfd
+    };
+
+    // Returns false for applications which must not be controlled
+    using AppFilterFn = std::function<bool(quint32 nameId)>;
+
+public:
+    ExternalControl();
+    ~ExternalControl();
+
+    inline bool isOk() const;
+    inline bool usesIoUring() const; // Writes don't go through "write()" then
+
+    void cleanup();
+
+    inline const std::vector<AppDescr> &applications() const;
+    inline std::vector<AppDescr> &applications();
+
+    bool setData(AppDescr &appDescr, double fps, const std::optional<bool> &forceImmediate);
+    void commit(); // Submits writes queued by "setData()"
+
+    void refresh();
+
+    // Also applies to the current applications, rejected ones get their defaults back
+    void setAppFilter(const AppFilterFn &appFilter);
+
+    // Application names are interned to small integers which never change
+    quint32 nameId(const QString &name);
+    inline quint32 nameCount() const;
+    inline const QString &name(quint32 nameId) const;
+
+private:
+    void watchDirLost();
+    void dirContentsChanged(const QString &path);
+    void dirEntriesChanged(const QStringList &created, const QStringList &removed);
+
+    bool addApplication(const QString &filePath);
+    void removeApplication(size_t idx);
+
+    void processExited(const QString &filePath);
+
+    bool writeRequested(AppDescr &appDescr);
+    void writeFailed(AppDescr &appDescr, int err);
+
+    void waitForWritable(AppDescr &appDescr);
+    void fifoWritable(const QString &filePath);
+
+    void scheduleRetry(AppDescr &appDescr);
+    void retryPending();
+    void retryWrite(AppDescr &appDescr);
+#ifdef USE_IO_URING
+    void writeCompleted(quint64 userData, int result);
+#endif
+
+    void closeFifo(AppDescr &appDescr);
+    void closeExitNotifier(AppDescr &appDescr);
+
+signals:
+    void applicationAdded(const ExternalControl::AppDescr &appDescr);
+    void applicationRemoved(const ExternalControl::AppDescr &appDescr);
+    void applicationsChanged();
+
+private:
+    const QDir m_flimesDir;
+    QFile m_flimesPlaceholderFile;
+
+    InotifyWatcher m_watcher;
+
+    QElapsedTimer m_retryClock;
+    QTimer m_retryTimer;
+
+#ifdef USE_IO_URING
+    std::unique_ptr<IoUring> m_ioUring;
+    quint64 m_ioUringSeq = 0;
+    QHash<quint64, std::pair<QString, int>> m_ioUringWrites; // User data -> file path and size
+#endif
+
+    bool m_ok = false;
+    bool m_cleanupDone = false;
+
+    std::vector<AppDescr> m_applications;
+    QHash<QString, size_t> m_appIndices; // File path -> index in "m_applications"
+
+    QHash<QString, quint32> m_nameIds;
+    QStringList m_names;
+
+    AppFilterFn m_appFilter;
+};
+
+/* Inline implementation */
+
+bool ExternalControl::isOk() const
+{
+    return m_ok;
+}
+bool ExternalControl::usesIoUring() const
+{
+#ifdef USE_IO_URING
+    return static_cast<bool>(m_ioUring);
+#else
+    return false;
+#endif
+}
+
+const std::vector<ExternalControl::AppDescr> &ExternalControl::applications() const
+{
+    return m_applications;
+}
+std::vector<ExternalControl::AppDescr> &ExternalControl::applications()
+{
+    return m_applications;
+}
+
+quint32 ExternalControl::nameCount() const
+{
+    return m_names.size();
+}
+const QString &ExternalControl::name(quint32 nameId) const
+{
+    return m_names.at(nameId);
+}
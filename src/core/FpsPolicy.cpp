@@ -0,0 +1,918 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "FpsPolicy.hpp"
+#include "ExternalControl.hpp"
+#include "X11ActiveWindow.hpp"
+#include "X11IdleMonitor.hpp"
+#include "PowerSupply.hpp"
+#include "ThermalSource.hpp"
+
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QSettings>
+
+#include <algorithm>
+
+bool FpsPolicy::s_inactiveImmediateModeDefault = false;
+
+using namespace std;
+
+static constexpr double s_fallbackRefreshRate = 60.0;
+
+static const char *limitModeToString(FpsPolicy::LimitMode mode)
+{
+    switch (mode)
+    {
+        case FpsPolicy::RefreshDivisorLimit:
+            return "RefreshDivisor";
+        case FpsPolicy::RefreshMinusLimit:
+            return "RefreshMinus";
+        default:
+            break;
+    }
+    return "Absolute";
+}
+static FpsPolicy::LimitMode limitModeFromString(const QString &str)
+{
+    if (str == "RefreshDivisor")
+        return FpsPolicy::RefreshDivisorLimit;
+    if (str == "RefreshMinus")
+        return FpsPolicy::RefreshMinusLimit;
+    return FpsPolicy::AbsoluteLimit;
+}
+
+static void sortBatteryCurve(FpsPolicy::BatteryCurve &batteryCurve)
+{
+    sort(batteryCurve.begin(), batteryCurve.end(), [](const FpsPolicy::BatteryStep &a, const FpsPolicy::BatteryStep &b) {
+        return a.capacity > b.capacity;
+    });
+}
+
+QString FpsPolicy::settingsFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + "/" VK_LAYER_FLIMES_GUI_NAME ".ini";
+}
+
+QString FpsPolicy::appSettingsFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + "/" VK_LAYER_FLIMES_GUI_NAME ".apps";
+}
+
+FpsPolicy::BatteryCurve FpsPolicy::parseBatteryCurve(const QString &str, bool *ok)
+{
+    BatteryCurve batteryCurve;
+
+    if (ok)
+        *ok = true;
+
+    for (auto &&stepStr : str.split(',', Qt::SkipEmptyParts))
+    {
+        const auto values = stepStr.split(':');
+
+        bool capacityOk = false;
+        bool fpsOk = false;
+
+        BatteryStep step;
+        if (values.size() == 2)
+        {
+            step.capacity = values[0].trimmed().toInt(&capacityOk);
+            step.fps = values[1].trimmed().toDouble(&fpsOk);
+        }
+
+        if (!capacityOk || !fpsOk || step.capacity < 0 || step.capacity > 100 || step.fps < 1.0)
+        {
+            if (ok)
+                *ok = false;
+            continue;
+        }
+
+        batteryCurve.push_back(step);
+    }
+
+    sortBatteryCurve(batteryCurve);
+
+    return batteryCurve;
+}
+QString FpsPolicy::batteryCurveToString(const BatteryCurve &batteryCurve)
+{
+    QStringList steps;
+    for (auto &&step : batteryCurve)
+        steps.push_back(QString("%1:%2").arg(step.capacity).arg(step.fps));
+    return steps.join(", ");
+}
+
+FpsPolicy::FpsPolicy()
+    : m_externalControl(make_unique<ExternalControl>())
+    , m_x11ActiveWindow(make_unique<X11ActiveWindow>())
+    , m_x11IdleMonitor(make_unique<X11IdleMonitor>())
+    , m_powerSupply(make_unique<PowerSupply>())
+    , m_thermalSource(make_unique<ThermalSource>())
+    , m_appSettingsStore(make_unique<AppSettingsStore>(appSettingsFilePath()))
+{
+    m_limits[ActiveTier].fps = 60.0;
+    m_limits[WindowedTier].fps = 30.0;
+    m_limits[InactiveTier].fps = 20.0;
+    m_limits[HiddenTier].fps = 5.0;
+    m_limits[IdleTier].fps = 10.0;
+    m_limits[BatteryTier].fps = 30.0;
+
+    m_updateTimer.setInterval(125);
+    m_updateTimer.setSingleShot(true);
+
+    connect(&m_updateTimer, &QTimer::timeout,
+            this, &FpsPolicy::update);
+
+    m_appWriteTimer.setInterval(s_appWriteDelay);
+    m_appWriteTimer.setSingleShot(true);
+
+    connect(&m_appWriteTimer, &QTimer::timeout,
+            this, &FpsPolicy::writeAppSettings);
+
+    connect(m_externalControl.get(), &ExternalControl::applicationsChanged,
+            this, &FpsPolicy::updateLater);
+    connect(m_externalControl.get(), &ExternalControl::applicationAdded,
+            this, [this](const ExternalControl::AppDescr &appDescr) {
+        if (appDescr.nameId >= m_appTable.flags.size())
+            invalidateAppTable();
+
+        ensureAppTableSize(appDescr.nameId + 1);
+        const auto now = QDateTime::currentSecsSinceEpoch();
+        m_appTable.lastUsed[appDescr.nameId] = now;
+        m_appTable.lastUsed[m_appTable.settingsIds[appDescr.nameId]] = now;
+
+        // The PID might have been reused, stale ancestors are rejected by their start time
+        m_processTree.update(appDescr.pid);
+    });
+    connect(m_externalControl.get(), &ExternalControl::applicationRemoved,
+            this, [this](const ExternalControl::AppDescr &appDescr) {
+        m_processTree.remove(appDescr.pid);
+        m_immediateModeRestored.remove(appDescr.pid);
+    });
+    connect(m_x11ActiveWindow.get(), &X11ActiveWindow::activeWindowPidChanged,
+            this, [this](pid_t pid) {
+        m_activeWindowPid = pid;
+        m_processTree.update(pid);
+        update();
+    });
+    connect(m_x11ActiveWindow.get(), &X11ActiveWindow::activeWindowFullscreenChanged,
+            this, &FpsPolicy::updateLater);
+    connect(m_x11ActiveWindow.get(), &X11ActiveWindow::hiddenPidsChanged,
+            this, [this] {
+        auto windowOwners = m_x11ActiveWindow->visiblePids();
+        windowOwners.unite(m_x11ActiveWindow->hiddenPids());
+        m_processTree.setWindowOwners(windowOwners);
+        updateLater();
+    });
+    connect(m_x11ActiveWindow.get(), &X11ActiveWindow::activeRefreshRateChanged,
+            this, &FpsPolicy::invalidateAppTable);
+    connect(m_x11IdleMonitor.get(), &X11IdleMonitor::idleChanged,
+            this, [this] {
+        if (!m_limits[IdleTier].enabled)
+            return;
+        // Restore the limits on the first input event without any delay
+        m_appTable.dirty = true;
+        update();
+    });
+    connect(m_powerSupply.get(), &PowerSupply::powerSourceChanged,
+            this, &FpsPolicy::invalidateAppTable);
+    connect(m_powerSupply.get(), &PowerSupply::batteryStateChanged,
+            this, [this] {
+        if (!m_batteryCurve.empty())
+            invalidateAppTable();
+    });
+    connect(m_thermalSource.get(), &ThermalSource::scaleChanged,
+            this, &FpsPolicy::invalidateAppTable);
+
+    setAppRules(AppRules::defaultRules());
+}
+FpsPolicy::~FpsPolicy()
+{
+}
+
+void FpsPolicy::load(QSettings &settings)
+{
+    s_inactiveImmediateModeDefault = settings.value("InactiveImmediateModeDefault").toBool();
+
+    const auto defaultFlags = defaultAppFlags();
+    for (auto &&flags : m_appTable.flags)
+        flags = defaultFlags | (flags & AppImmediateModeModified);
+    fill(m_appTable.activeFps.begin(), m_appTable.activeFps.end(), 0.0);
+    fill(m_appTable.inactiveFps.begin(), m_appTable.inactiveFps.end(), 0.0);
+    fill(m_appTable.batteryFps.begin(), m_appTable.batteryFps.end(), 0.0);
+
+    const auto setAppEntry = [this](quint32 nameId, quint16 entryFlags, double activeFps, double inactiveFps, double batteryFps) {
+        ensureAppTableSize(nameId + 1);
+
+        m_appTable.activeFps[nameId] = activeFps;
+        m_appTable.inactiveFps[nameId] = inactiveFps;
+        m_appTable.batteryFps[nameId] = batteryFps;
+
+        auto &flags = m_appTable.flags[nameId];
+        flags = (entryFlags & ~AppImmediateModeModified) | AppModified | (flags & AppImmediateModeModified);
+        if (flags & (AppInactiveImmediateMode | AppBypassImmediateMode))
+            flags |= AppImmediateModeModified;
+    };
+
+    // Application groups in the settings file are migrated to the store when saving
+    m_dirtyAppSettings.clear();
+    m_appEntriesEvicted = false;
+    if (m_appSettingsStore->exists())
+    {
+        // Evicted entries are skipped before their names are interned
+        auto entries = m_appSettingsStore->load();
+        m_appEntriesEvicted = evictAppEntries(entries);
+        for (auto &&entry : entries)
+        {
+            const auto nameId = m_externalControl->nameId(entry.name);
+            setAppEntry(nameId, entry.flags, entry.activeFps, entry.inactiveFps, entry.batteryFps);
+            m_appTable.lastUsed[nameId] = entry.lastUsed;
+        }
+    }
+    else for (auto &&group : settings.childGroups())
+    {
+        if (group == "Rules")
+            continue;
+
+        AppSettings appSettings;
+        appSettings.active = settings.value(group + "/Active", appSettings.active).toBool();
+        appSettings.windowed = settings.value(group + "/Windowed", appSettings.windowed).toBool();
+        appSettings.inactive = settings.value(group + "/Inactive", appSettings.inactive).toBool();
+        appSettings.battery = settings.value(group + "/Battery", appSettings.battery).toBool();
+        appSettings.hidden = settings.value(group + "/Hidden", appSettings.hidden).toBool();
+        appSettings.idle = settings.value(group + "/Idle", appSettings.idle).toBool();
+        appSettings.inactiveImmediateMode = settings.value(group + "/InactiveImmediateMode", appSettings.inactiveImmediateMode).toBool();
+        appSettings.bypassImmediateMode = settings.value(group + "/BypassImmediateMode", appSettings.bypassImmediateMode).toBool();
+        appSettings.activeFps = settings.value(group + "/ActiveFps", appSettings.activeFps).toDouble();
+        appSettings.inactiveFps = settings.value(group + "/InactiveFps", appSettings.inactiveFps).toDouble();
+        appSettings.batteryFps = settings.value(group + "/BatteryFps", appSettings.batteryFps).toDouble();
+
+        const auto nameId = m_externalControl->nameId(group);
+        setAppEntry(nameId, appFlags(appSettings), appSettings.activeFps, appSettings.inactiveFps, appSettings.batteryFps);
+        m_appTable.lastUsed[nameId] = QDateTime::currentSecsSinceEpoch();
+    }
+
+    m_limits[ActiveTier].enabled = settings.value("ActiveFpsChecked").toBool();
+    m_limits[ActiveTier].fps = settings.value("ActiveFps", 60.0).toDouble();
+    m_limits[ActiveTier].mode = limitModeFromString(settings.value("ActiveFpsMode").toString());
+    if (m_x11ActiveWindow->isOk())
+    {
+        m_limits[WindowedTier].enabled = settings.value("WindowedFpsChecked").toBool();
+        m_limits[WindowedTier].fps = settings.value("WindowedFps", 30.0).toDouble();
+        m_limits[WindowedTier].mode = limitModeFromString(settings.value("WindowedFpsMode").toString());
+        m_limits[InactiveTier].enabled = settings.value("InactiveFpsChecked").toBool();
+        m_limits[InactiveTier].fps = settings.value("InactiveFps", 20.0).toDouble();
+        m_limits[InactiveTier].mode = limitModeFromString(settings.value("InactiveFpsMode").toString());
+        m_limits[HiddenTier].enabled = settings.value("HiddenFpsChecked").toBool();
+        m_limits[HiddenTier].fps = settings.value("HiddenFps", 5.0).toDouble();
+        m_limits[HiddenTier].mode = limitModeFromString(settings.value("HiddenFpsMode").toString());
+    }
+    if (m_x11IdleMonitor->isOk())
+    {
+        m_limits[IdleTier].enabled = settings.value("IdleFpsChecked").toBool();
+        m_limits[IdleTier].fps = settings.value("IdleFps", 10.0).toDouble();
+        m_limits[IdleTier].mode = limitModeFromString(settings.value("IdleFpsMode").toString());
+        m_x11IdleMonitor->setTimeout(settings.value("IdleTimeout", 300).toInt());
+    }
+    if (m_powerSupply->isOk())
+    {
+        m_limits[BatteryTier].enabled = settings.value("BatteryFpsChecked").toBool();
+        m_limits[BatteryTier].fps = settings.value("BatteryFps", 30.0).toDouble();
+        m_limits[BatteryTier].mode = limitModeFromString(settings.value("BatteryFpsMode").toString());
+        m_batteryCurve = parseBatteryCurve(settings.value("BatteryCurve").toString());
+    }
+    for (int tier = 0; tier < TierCount; ++tier)
+        resolveRefreshMode(static_cast<Tier>(tier));
+
+    m_thermalSource->setSysfsRoot(settings.value("ThermalSysfsRoot", ThermalSource::s_defaultSysfsRoot).toString());
+    m_thermalSource->setCeiling(settings.value("ThermalCeiling", 85.0).toDouble());
+    m_thermalSource->setEnabled(settings.value("ThermalChecked").toBool());
+
+    auto appRules = AppRules::defaultRules();
+    if (settings.contains("Rules/size"))
+    {
+        appRules.clear();
+        const int size = settings.beginReadArray("Rules");
+        for (int i = 0; i < size; ++i)
+        {
+            settings.setArrayIndex(i);
+
+            AppRules::Rule rule;
+            rule.syntax = AppRules::syntaxFromString(settings.value("Syntax").toString());
+            rule.pattern = settings.value("Pattern").toString();
+            rule.profile = settings.value("Profile").toString();
+            rule.ignore = settings.value("Ignore").toBool();
+            appRules.push_back(rule);
+        }
+        settings.endArray();
+    }
+    setAppRules(appRules);
+}
+void FpsPolicy::save(QSettings &settings)
+{
+    settings.setValue("InactiveImmediateModeDefault", s_inactiveImmediateModeDefault);
+
+    settings.setValue("ActiveFpsChecked", m_limits[ActiveTier].enabled);
+    settings.setValue("ActiveFps", m_limits[ActiveTier].fps);
+    settings.setValue("ActiveFpsMode", limitModeToString(m_limits[ActiveTier].mode));
+    if (m_x11ActiveWindow->isOk())
+    {
+        settings.setValue("WindowedFpsChecked", m_limits[WindowedTier].enabled);
+        settings.setValue("WindowedFps", m_limits[WindowedTier].fps);
+        settings.setValue("WindowedFpsMode", limitModeToString(m_limits[WindowedTier].mode));
+        settings.setValue("InactiveFpsChecked", m_limits[InactiveTier].enabled);
+        settings.setValue("InactiveFps", m_limits[InactiveTier].fps);
+        settings.setValue("InactiveFpsMode", limitModeToString(m_limits[InactiveTier].mode));
+        settings.setValue("HiddenFpsChecked", m_limits[HiddenTier].enabled);
+        settings.setValue("HiddenFps", m_limits[HiddenTier].fps);
+        settings.setValue("HiddenFpsMode", limitModeToString(m_limits[HiddenTier].mode));
+    }
+    if (m_x11IdleMonitor->isOk())
+    {
+        settings.setValue("IdleFpsChecked", m_limits[IdleTier].enabled);
+        settings.setValue("IdleFps", m_limits[IdleTier].fps);
+        settings.setValue("IdleFpsMode", limitModeToString(m_limits[IdleTier].mode));
+        settings.setValue("IdleTimeout", m_x11IdleMonitor->timeout());
+    }
+    if (m_powerSupply->isOk())
+    {
+        settings.setValue("BatteryFpsChecked", m_limits[BatteryTier].enabled);
+        settings.setValue("BatteryFps", m_limits[BatteryTier].fps);
+        settings.setValue("BatteryFpsMode", limitModeToString(m_limits[BatteryTier].mode));
+        settings.setValue("BatteryCurve", batteryCurveToString(m_batteryCurve));
+    }
+    if (m_thermalSource->isOk())
+    {
+        settings.setValue("ThermalChecked", m_thermalSource->isEnabled());
+        settings.setValue("ThermalCeiling", m_thermalSource->ceiling());
+    }
+
+    const auto &appRules = m_appRules.rules();
+    settings.remove("Rules");
+    settings.beginWriteArray("Rules", appRules.size());
+    for (size_t i = 0; i < appRules.size(); ++i)
+    {
+        const auto &rule = appRules[i];
+        settings.setArrayIndex(i);
+        settings.setValue("Syntax", AppRules::syntaxToString(rule.syntax));
+        settings.setValue("Pattern", rule.pattern);
+        settings.setValue("Profile", rule.profile);
+        settings.setValue("Ignore", rule.ignore);
+    }
+    settings.endArray();
+
+    // Changes are already journaled, the store is rewritten only if something has to be dropped
+    writeAppSettings();
+    bool evicted = false;
+    const auto entries = appEntries(&evicted);
+    if (!m_appSettingsStore->isWritable() || !m_appSettingsStore->exists() || evicted || m_appEntriesEvicted)
+    {
+        m_appSettingsStore->setWritable(true);
+        m_appSettingsStore->compact(entries);
+        m_appEntriesEvicted = false;
+
+        // Dropped entries must not cause another compaction on the next save
+        if (evicted)
+        {
+            QSet<QString> kept;
+            for (auto &&entry : entries)
+                kept.insert(entry.name);
+            for (quint32 nameId = 0; nameId < m_appTable.flags.size(); ++nameId)
+            {
+                if ((m_appTable.flags[nameId] & AppModified) && !kept.contains(m_externalControl->name(nameId)))
+                    m_appTable.flags[nameId] &= ~AppModified;
+            }
+        }
+    }
+    if (m_appSettingsStore->flush())
+    {
+        for (auto &&group : settings.childGroups())
+        {
+            if (group != "Rules")
+                settings.remove(group);
+        }
+    }
+}
+
+double FpsPolicy::limitFps(Tier tier) const
+{
+    const auto &limit = m_limits[tier];
+    if (limit.mode == AbsoluteLimit)
+        return limit.fps;
+
+    const double refreshRate = activeRefreshRate();
+    if (limit.mode == RefreshDivisorLimit)
+        return refreshRate / qMax(limit.fps, 1.0);
+    return qMax(refreshRate - limit.fps, 1.0);
+}
+
+double FpsPolicy::activeRefreshRate() const
+{
+    const double refreshRate = m_x11ActiveWindow->activeRefreshRate();
+    return (refreshRate > 0.0)
+        ? refreshRate
+        : s_fallbackRefreshRate
+    ;
+}
+void FpsPolicy::resolveRefreshMode(Tier tier)
+{
+    // Limits of other tiers are converted to FPS for the current refresh rate, e.g. from older settings
+    auto &limit = m_limits[tier];
+    if (hasRefreshModes(tier) || limit.mode == AbsoluteLimit)
+        return;
+
+    limit.fps = limitFps(tier);
+    limit.mode = AbsoluteLimit;
+}
+
+void FpsPolicy::setLimit(Tier tier, const Limit &limit)
+{
+    m_limits[tier] = limit;
+    resolveRefreshMode(tier);
+    invalidateAppTable();
+}
+
+void FpsPolicy::setBatteryCurve(const BatteryCurve &batteryCurve)
+{
+    m_batteryCurve = batteryCurve;
+    sortBatteryCurve(m_batteryCurve);
+    invalidateAppTable();
+}
+
+void FpsPolicy::setBypass(bool bypass)
+{
+    m_bypass = bypass;
+    invalidateAppTable();
+}
+
+void FpsPolicy::setInactiveImmediateModeDefault(bool inactiveImmediateModeDefault)
+{
+    bool changed = false;
+    s_inactiveImmediateModeDefault = inactiveImmediateModeDefault;
+    for (auto &&flags : m_appTable.flags)
+    {
+        if (!(flags & AppModified) && static_cast<bool>(flags & AppInactiveImmediateMode) != s_inactiveImmediateModeDefault)
+        {
+            flags ^= AppInactiveImmediateMode;
+            if (flags & AppInactiveImmediateMode)
+                flags |= AppImmediateModeModified;
+            changed = true;
+        }
+    }
+    if (changed)
+    {
+        emit appSettingsChanged();
+        invalidateAppTable();
+    }
+}
+
+FpsPolicy::AppSettings FpsPolicy::appSettings(quint32 nameId) const
+{
+    nameId = settingsId(nameId);
+
+    AppSettings settings;
+    if (nameId < m_appTable.flags.size())
+    {
+        const auto flags = m_appTable.flags[nameId];
+        settings.modified = (flags & AppModified);
+        settings.active = (flags & AppActive);
+        settings.windowed = (flags & AppWindowed);
+        settings.inactive = (flags & AppInactive);
+        settings.battery = (flags & AppBattery);
+        settings.hidden = (flags & AppHidden);
+        settings.idle = (flags & AppIdle);
+        settings.inactiveImmediateMode = (flags & AppInactiveImmediateMode);
+        settings.bypassImmediateMode = (flags & AppBypassImmediateMode);
+        settings.immediateModeModified = (flags & AppImmediateModeModified);
+        settings.activeFps = m_appTable.activeFps[nameId];
+        settings.inactiveFps = m_appTable.inactiveFps[nameId];
+        settings.batteryFps = m_appTable.batteryFps[nameId];
+    }
+    return settings;
+}
+void FpsPolicy::setAppSettings(quint32 nameId, const AppSettings &settings)
+{
+    ensureAppTableSize(nameId + 1);
+    nameId = m_appTable.settingsIds[nameId];
+
+    auto &flags = m_appTable.flags[nameId];
+    flags = appFlags(settings) | AppModified | (flags & AppImmediateModeModified);
+    if (flags & (AppInactiveImmediateMode | AppBypassImmediateMode))
+        flags |= AppImmediateModeModified;
+
+    m_appTable.activeFps[nameId] = settings.activeFps;
+    m_appTable.inactiveFps[nameId] = settings.inactiveFps;
+    m_appTable.batteryFps[nameId] = settings.batteryFps;
+
+    m_dirtyAppSettings.insert(nameId);
+    m_appWriteTimer.start();
+
+    invalidateAppTable();
+}
+
+void FpsPolicy::setAppRules(const vector<AppRules::Rule> &rules)
+{
+    m_appRules.setRules(rules);
+
+    m_appRuleProfileIds.clear();
+    for (auto &&rule : m_appRules.rules())
+        m_appRuleProfileIds.push_back(rule.profile.isEmpty() ? 0 : m_externalControl->nameId(rule.profile));
+
+    ensureAppTableSize(m_externalControl->nameCount());
+    resolveAppRules(0);
+
+    m_externalControl->setAppFilter([this](quint32 nameId) {
+        return !isIgnored(nameId);
+    });
+
+    emit appSettingsChanged();
+    invalidateAppTable();
+}
+
+void FpsPolicy::setAppSettingsWriteBehind(bool enabled)
+{
+    m_appSettingsStore->setWritable(enabled);
+
+    // Appended entries must not be the only ones in a new store
+    if (enabled && (!m_appSettingsStore->exists() || m_appEntriesEvicted))
+    {
+        m_appSettingsStore->compact(appEntries());
+        m_appEntriesEvicted = false;
+    }
+}
+
+void FpsPolicy::writeAppSettings()
+{
+    m_appWriteTimer.stop();
+    for (auto &&nameId : m_dirtyAppSettings)
+        m_appSettingsStore->put(appEntry(nameId));
+    m_dirtyAppSettings.clear();
+}
+
+void FpsPolicy::updateLater()
+{
+    m_updateTimer.start();
+}
+void FpsPolicy::update()
+{
+    m_updateTimer.stop();
+
+    if (m_appTable.dirty)
+        computeAppTable();
+
+    for (auto &&app : m_externalControl->applications())
+    {
+        const auto nameId = app.nameId;
+        const auto state = appState(app.pid);
+
+        const double fps = m_appTable.fps[state][nameId];
+        const qint8 immediate = m_appTable.immediate[state][nameId];
+
+        optional<bool> forceImmediate;
+        if (immediate > -1)
+        {
+            forceImmediate = (immediate != 0);
+            m_immediateModeRestored.remove(app.pid);
+        }
+        else if ((m_appTable.flags[m_appTable.settingsIds[nameId]] & AppImmediateModeModified) && !m_immediateModeRestored.contains(app.pid))
+        {
+            // Immediate mode has been disabled, restore the default once for every application of the profile
+            forceImmediate = false;
+            m_immediateModeRestored.insert(app.pid);
+        }
+
+        m_externalControl->setData(app, fps, forceImmediate);
+    }
+    m_externalControl->commit();
+}
+
+void FpsPolicy::shutdown()
+{
+    if (m_externalControl->isOk())
+    {
+        const double fps = m_limits[ActiveTier].enabled
+            ? limitFps(ActiveTier)
+            : 0.0
+        ;
+        for (auto &&app : m_externalControl->applications())
+        {
+            const auto settings = appSettings(app.nameId);
+            optional<bool> forceImmediate;
+            if (settings.inactiveImmediateMode || (settings.bypassImmediateMode && m_bypass))
+                forceImmediate = false;
+            const double appFps = (m_limits[ActiveTier].enabled && settings.activeFps > 0.0)
+                ? settings.activeFps
+                : fps
+            ;
+            m_externalControl->setData(app, settings.active ? appFps : 0.0, forceImmediate);
+        }
+        m_externalControl->commit();
+    }
+
+    m_updateTimer.stop();
+
+    m_externalControl->cleanup();
+}
+
+quint16 FpsPolicy::appFlags(const AppSettings &settings)
+{
+    quint16 flags = 0;
+    if (settings.active)
+        flags |= AppActive;
+    if (settings.windowed)
+        flags |= AppWindowed;
+    if (settings.inactive)
+        flags |= AppInactive;
+    if (settings.battery)
+        flags |= AppBattery;
+    if (settings.hidden)
+        flags |= AppHidden;
+    if (settings.idle)
+        flags |= AppIdle;
+    if (settings.inactiveImmediateMode)
+        flags |= AppInactiveImmediateMode;
+    if (settings.bypassImmediateMode)
+        flags |= AppBypassImmediateMode;
+    return flags;
+}
+quint16 FpsPolicy::defaultAppFlags() const
+{
+    const AppSettings settings;
+    return appFlags(settings) | (settings.immediateModeModified ? AppImmediateModeModified : 0);
+}
+
+AppSettingsStore::Entry FpsPolicy::appEntry(quint32 nameId) const
+{
+    AppSettingsStore::Entry entry;
+    entry.name = m_externalControl->name(nameId);
+    entry.flags = m_appTable.flags[nameId] & ~AppImmediateModeModified;
+    entry.activeFps = m_appTable.activeFps[nameId];
+    entry.inactiveFps = m_appTable.inactiveFps[nameId];
+    entry.batteryFps = m_appTable.batteryFps[nameId];
+    entry.lastUsed = m_appTable.lastUsed[nameId];
+    return entry;
+}
+
+vector<AppSettingsStore::Entry> FpsPolicy::appEntries(bool *evicted) const
+{
+    vector<AppSettingsStore::Entry> entries;
+    for (quint32 nameId = 0; nameId < m_appTable.flags.size(); ++nameId)
+    {
+        if (m_appTable.flags[nameId] & AppModified)
+            entries.push_back(appEntry(nameId));
+    }
+
+    const bool anyEvicted = evictAppEntries(entries);
+    if (evicted)
+        *evicted = anyEvicted;
+    return entries;
+}
+bool FpsPolicy::evictAppEntries(vector<AppSettingsStore::Entry> &entries) const
+{
+    const size_t count = entries.size();
+
+    // Entries equal to the defaults are evicted when they haven't been used for a long time
+    const qint64 evictBefore = QDateTime::currentSecsSinceEpoch() - s_appEvictAge;
+    const quint16 defaultsMask = ~(AppModified | AppImmediateModeModified);
+    const quint16 defaultFlags = defaultAppFlags() & defaultsMask;
+    entries.erase(remove_if(entries.begin(), entries.end(), [&](const AppSettingsStore::Entry &entry) {
+        const bool isDefault = ((entry.flags & defaultsMask) == defaultFlags && entry.activeFps == 0.0 && entry.inactiveFps == 0.0 && entry.batteryFps == 0.0);
+        return (isDefault && entry.lastUsed < evictBefore);
+    }), entries.end());
+
+    // Then the least recently used ones above the limit
+    if (entries.size() > s_appMaxEntries)
+    {
+        nth_element(entries.begin(), entries.begin() + s_appMaxEntries, entries.end(), [](const AppSettingsStore::Entry &a, const AppSettingsStore::Entry &b) {
+            return (a.lastUsed > b.lastUsed);
+        });
+        entries.resize(s_appMaxEntries);
+    }
+
+    return (entries.size() != count);
+}
+
+void FpsPolicy::ensureAppTableSize(quint32 size)
+{
+    // Rule profiles are interned too, so every name ID must have its entry
+    size = qMax(size, m_externalControl->nameCount());
+    if (size <= m_appTable.flags.size())
+        return;
+
+    const quint32 first = m_appTable.flags.size();
+
+    m_appTable.flags.resize(size, defaultAppFlags());
+    m_appTable.activeFps.resize(size);
+    m_appTable.inactiveFps.resize(size);
+    m_appTable.batteryFps.resize(size);
+    m_appTable.lastUsed.resize(size);
+    m_appTable.settingsIds.resize(size);
+    m_appTable.ignored.resize(size);
+    for (int state = 0; state < AppStateCount; ++state)
+    {
+        m_appTable.fps[state].resize(size);
+        m_appTable.immediate[state].resize(size);
+    }
+    m_appTable.dirty = true;
+
+    resolveAppRules(first);
+}
+void FpsPolicy::resolveAppRules(quint32 first)
+{
+    // Matching is done once per name, the results are used by index
+    const quint32 size = m_appTable.settingsIds.size();
+    for (quint32 nameId = first; nameId < size; ++nameId)
+    {
+        quint32 settingsId = nameId;
+        bool ignored = false;
+
+        // Profiles use their own settings, so they don't chain
+        bool isProfile = false;
+        for (size_t i = 0; i < m_appRuleProfileIds.size() && !isProfile; ++i)
+            isProfile = (!m_appRules.rules()[i].profile.isEmpty() && m_appRuleProfileIds[i] == nameId);
+
+        const int ruleIdx = isProfile ? -1 : m_appRules.match(m_externalControl->name(nameId));
+        if (ruleIdx > -1)
+        {
+            const auto &rule = m_appRules.rules()[ruleIdx];
+            if (rule.ignore)
+                ignored = true;
+            else if (!rule.profile.isEmpty())
+                settingsId = m_appRuleProfileIds[ruleIdx];
+        }
+
+        m_appTable.settingsIds[nameId] = settingsId;
+        m_appTable.ignored[nameId] = ignored;
+    }
+    m_appTable.dirty = true;
+}
+bool FpsPolicy::isIgnored(quint32 nameId)
+{
+    ensureAppTableSize(nameId + 1);
+    return m_appTable.ignored[nameId];
+}
+void FpsPolicy::invalidateAppTable()
+{
+    m_appTable.dirty = true;
+    updateLater();
+}
+void FpsPolicy::computeAppTable()
+{
+    ensureAppTableSize(m_externalControl->nameCount());
+
+    double activeFps = m_limits[ActiveTier].enabled
+        ? limitFps(ActiveTier)
+        : 0.0
+    ;
+    // Without an active limit thermal throttling scales down the refresh rate
+    const double thermalScale = m_thermalSource->scale();
+    if (activeFps == 0.0 && thermalScale < 1.0)
+        activeFps = activeRefreshRate();
+
+    double windowedFps = limitFps(WindowedTier);
+    double inactiveFps = m_limits[InactiveTier].enabled
+        ? limitFps(InactiveTier)
+        : activeFps
+    ;
+    double hiddenFps = limitFps(HiddenTier);
+    double idleFps = limitFps(IdleTier);
+    double batteryFps = m_limits[BatteryTier].enabled
+        ? limitFps(BatteryTier)
+        : activeFps
+    ;
+
+    const int capacity = m_powerSupply->capacity();
+    if (m_limits[BatteryTier].enabled && capacity > -1)
+    {
+        for (auto &&step : m_batteryCurve)
+        {
+            if (capacity <= step.capacity)
+                batteryFps = step.fps;
+        }
+    }
+
+    const bool battery = (m_powerSupply->isOk() && m_powerSupply->isBattery());
+    const bool idle = (m_limits[IdleTier].enabled && m_x11IdleMonitor->isIdle());
+    const bool bypass = m_bypass;
+
+    // Thermal throttling scales down the enabled limits
+    activeFps *= thermalScale;
+    windowedFps *= thermalScale;
+    inactiveFps *= thermalScale;
+    hiddenFps *= thermalScale;
+    idleFps *= thermalScale;
+    batteryFps *= thermalScale;
+
+    const auto isActive = [](AppState state) {
+        return (state == AppStateActive || state == AppStateActiveWindowed);
+    };
+    // Per application values replace the global values of the enabled tiers
+    const auto appFps = [&](Tier tier, const vector<double> &values, size_t i, double globalFps, double disabledFps) {
+        if (!m_limits[tier].enabled)
+            return disabledFps;
+        if (values[i] > 0.0)
+            return values[i] * thermalScale;
+        return globalFps;
+    };
+    const auto limitFps = [&](quint16 flags, AppState state, double activeFps, double inactiveFps, double batteryFps) {
+        double fps = 0.0;
+        if (!bypass)
+        {
+            if (flags & AppActive)
+                fps = activeFps;
+            if (state == AppStateActiveWindowed && (flags & AppWindowed) && m_limits[WindowedTier].enabled)
+                fps = windowedFps;
+            if (!isActive(state) && (flags & AppInactive))
+                fps = inactiveFps;
+            if (state == AppStateHidden && (flags & AppHidden) && m_limits[HiddenTier].enabled)
+                fps = hiddenFps;
+            if (battery && (flags & AppBattery) && (fps == 0.0 || batteryFps < fps))
+                fps = batteryFps;
+            if (idle && (flags & AppIdle) && (fps == 0.0 || idleFps < fps))
+                fps = idleFps;
+        }
+        return fps;
+    };
+    const auto immediateMode = [&](quint16 flags, AppState state) {
+        qint8 immediate = -1;
+        if (flags & AppInactiveImmediateMode)
+            immediate = !isActive(state);
+        if ((flags & AppBypassImmediateMode) && (immediate < 0 || bypass))
+            immediate = bypass;
+        return immediate;
+    };
+
+    const size_t n = m_appTable.flags.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const auto settingsId = m_appTable.settingsIds[i];
+        const auto flags = m_appTable.flags[settingsId];
+        const double appActiveFps = appFps(ActiveTier, m_appTable.activeFps, settingsId, activeFps, activeFps);
+        const double appInactiveFps = appFps(InactiveTier, m_appTable.inactiveFps, settingsId, inactiveFps, appActiveFps);
+        const double appBatteryFps = appFps(BatteryTier, m_appTable.batteryFps, settingsId, batteryFps, appActiveFps);
+        for (int state = 0; state < AppStateCount; ++state)
+        {
+            m_appTable.fps[state][i] = limitFps(flags, static_cast<AppState>(state), appActiveFps, appInactiveFps, appBatteryFps);
+            m_appTable.immediate[state][i] = immediateMode(flags, static_cast<AppState>(state));
+        }
+    }
+
+    m_appTable.dirty = false;
+}
+
+FpsPolicy::AppState FpsPolicy::appState(pid_t pid)
+{
+    if (!m_x11ActiveWindow->isOk())
+        return AppStateActive;
+
+    // Launchers, Wine and Proton can own the window in a different process
+    if (m_processTree.isRelated(pid, m_activeWindowPid))
+    {
+        return m_x11ActiveWindow->isActiveWindowFullscreen()
+            ? AppStateActive
+            : AppStateActiveWindowed
+        ;
+    }
+
+    const auto &hiddenPids = m_x11ActiveWindow->hiddenPids();
+    if (hiddenPids.isEmpty())
+        return AppStateInactive;
+    if (hiddenPids.contains(pid))
+        return AppStateHidden;
+
+    const auto &visiblePids = m_x11ActiveWindow->visiblePids();
+    if (visiblePids.contains(pid))
+        return AppStateInactive;
+    for (auto &&visiblePid : visiblePids)
+    {
+        if (m_processTree.isRelated(pid, visiblePid))
+            return AppStateInactive;
+    }
+    for (auto &&hiddenPid : hiddenPids)
+    {
+        if (m_processTree.isRelated(pid, hiddenPid))
+            return AppStateHidden;
+    }
+    return AppStateInactive;
+}
@@ -0,0 +1,314 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "ProcessTree.hpp"
+#include "AppRules.hpp"
+#include "AppSettingsStore.hpp"
+
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+class ExternalControl;
+class X11ActiveWindow;
+class X11IdleMonitor;
+class PowerSupply;
+class ThermalSource;
+
+class QSettings;
+
+class FpsPolicy : public QObject
+{
+    Q_OBJECT
+
+    static bool s_inactiveImmediateModeDefault;
+
+    static constexpr qint64 s_appEvictAge = 90 * 24 * 60 * 60; // Seconds
+    static constexpr size_t s_appMaxEntries = 1000; // Least recently used entries are evicted above
+    static constexpr int s_appWriteDelay = 1000; // ms, coalesces e.g. spin box steps
+
+public:
+    enum Tier
+    {
+        ActiveTier,
+        WindowedTier, // Active, but not fullscreen
+        InactiveTier,
+        BatteryTier,
+        HiddenTier,
+        IdleTier, // No user input for a while
+
+        TierCount
+    };
+
+    enum LimitMode
+    {
+        AbsoluteLimit,
+        RefreshDivisorLimit, // Refresh rate / "fps"
+        RefreshMinusLimit, // Refresh rate - "fps"
+    };
+
+    struct Limit
+    {
+        bool enabled = false;
+        double fps = 0.0;
+        LimitMode mode = AbsoluteLimit;
+    };
+
+    // Battery FPS used at or below the given capacity
+    struct BatteryStep
+    {
+        int capacity = 0;
+        double fps = 0.0;
+    };
+    using BatteryCurve = std::vector<BatteryStep>;
+
+    struct AppSettings
+    {
+        bool modified = false;
+
+        bool active = true;
+        bool windowed = true;
+        bool inactive = true;
+        bool battery = true;
+        bool hidden = true;
+        bool idle = true;
+
+        bool inactiveImmediateMode = s_inactiveImmediateModeDefault;
+        bool bypassImmediateMode = false;
+
+        // Replace the global values of the enabled tiers, 0.0: use the global value
+        double activeFps = 0.0;
+        double inactiveFps = 0.0;
+        double batteryFps = 0.0;
+
+        bool immediateModeModified = (inactiveImmediateMode || bypassImmediateMode);
+    };
+
+public:
+    static QString settingsFilePath();
+    static QString appSettingsFilePath();
+
+    // Format: "capacity:fps, ...", e.g. "50:30, 15:20"
+    static BatteryCurve parseBatteryCurve(const QString &str, bool *ok = nullptr);
+    static QString batteryCurveToString(const BatteryCurve &batteryCurve);
+
+    FpsPolicy();
+    ~FpsPolicy();
+
+    inline ExternalControl *externalControl() const;
+    inline X11ActiveWindow *x11ActiveWindow() const;
+    inline X11IdleMonitor *x11IdleMonitor() const;
+    inline PowerSupply *powerSupply() const;
+    inline ThermalSource *thermalSource() const;
+
+    void load(QSettings &settings);
+    void save(QSettings &settings);
+
+    // Application settings changes are written right away, off the calling thread
+    void setAppSettingsWriteBehind(bool enabled);
+
+    // Only the tiers of the active window, other applications can be shown on other monitors
+    static inline bool hasRefreshModes(Tier tier);
+
+    inline Limit limit(Tier tier) const;
+    double limitFps(Tier tier) const; // Resolved for the refresh rate of the active window monitor
+    void setLimit(Tier tier, const Limit &limit);
+
+    inline const BatteryCurve &batteryCurve() const;
+    void setBatteryCurve(const BatteryCurve &batteryCurve);
+
+    inline bool isBypass() const;
+    void setBypass(bool bypass);
+
+    inline bool inactiveImmediateModeDefault() const;
+    void setInactiveImmediateModeDefault(bool inactiveImmediateModeDefault);
+
+    // "nameId" comes from "ExternalControl::nameId()", settings of the matching rule profile are used
+    AppSettings appSettings(quint32 nameId) const;
+    void setAppSettings(quint32 nameId, const AppSettings &settings);
+
+    inline const AppRules &appRules() const;
+    void setAppRules(const std::vector<AppRules::Rule> &rules);
+
+    // Name ID whose settings are used for the application
+    inline quint32 settingsId(quint32 nameId) const;
+
+    void updateLater();
+    void update();
+
+    // Writes the limits used when nothing controls the applications anymore
+    void shutdown();
+
+signals:
+    void appSettingsChanged();
+
+private:
+    enum AppFlag : quint16
+    {
+        AppModified = 0x01,
+        AppActive = 0x02,
+        AppInactive = 0x04,
+        AppBattery = 0x08,
+        AppInactiveImmediateMode = 0x10,
+        AppBypassImmediateMode = 0x20,
+        AppImmediateModeModified = 0x40,
+        AppHidden = 0x80,
+        AppWindowed = 0x100,
+        AppIdle = 0x200,
+    };
+
+    enum AppState
+    {
+        AppStateActive,
+        AppStateActiveWindowed,
+        AppStateInactive,
+        AppStateHidden, // Inactive and all windows are minimized or hidden
+
+        AppStateCount
+    };
+
+    static quint16 appFlags(const AppSettings &settings);
+    quint16 defaultAppFlags() const;
+
+    double activeRefreshRate() const; // Fallback value if unknown
+
+    AppSettingsStore::Entry appEntry(quint32 nameId) const;
+    std::vector<AppSettingsStore::Entry> appEntries(bool *evicted = nullptr) const;
+    bool evictAppEntries(std::vector<AppSettingsStore::Entry> &entries) const;
+    void writeAppSettings();
+
+    void ensureAppTableSize(quint32 size);
+    void resolveAppRules(quint32 first);
+    void resolveRefreshMode(Tier tier);
+    bool isIgnored(quint32 nameId);
+    void invalidateAppTable();
+    void computeAppTable();
+
+    AppState appState(pid_t pid);
+
+private:
+    const std::unique_ptr<ExternalControl> m_externalControl;
+    const std::unique_ptr<X11ActiveWindow> m_x11ActiveWindow;
+    const std::unique_ptr<X11IdleMonitor> m_x11IdleMonitor;
+    const std::unique_ptr<PowerSupply> m_powerSupply;
+    const std::unique_ptr<ThermalSource> m_thermalSource;
+    const std::unique_ptr<AppSettingsStore> m_appSettingsStore;
+
+    Limit m_limits[TierCount];
+    BatteryCurve m_batteryCurve; // Sorted by descending capacity
+
+    AppRules m_appRules;
+    std::vector<quint32> m_appRuleProfileIds; // Name ID of each rule profile
+
+    bool m_bypass = false;
+
+    // Structure of arrays indexed by the name ID, the limits are computed for all applications at once
+    struct AppTable
+    {
+        std::vector<quint16> flags;
+        std::vector<double> activeFps;
+        std::vector<double> inactiveFps;
+        std::vector<double> batteryFps;
+        std::vector<qint64> lastUsed;
+        std::vector<quint32> settingsIds; // Rule matching results
+        std::vector<bool> ignored;
+        std::vector<double> fps[AppStateCount];
+        std::vector<qint8> immediate[AppStateCount]; // -1: don't force, 0: force off, 1: force on
+        bool dirty = true;
+    } m_appTable;
+    QSet<qint64> m_immediateModeRestored; // PIDs which don't need the immediate mode restored anymore
+
+    QTimer m_updateTimer;
+
+    QTimer m_appWriteTimer;
+    QSet<quint32> m_dirtyAppSettings; // Written to the store when the timer fires
+    bool m_appEntriesEvicted = false; // At load, the store must be compacted
+
+    pid_t m_activeWindowPid = 0;
+    ProcessTree m_processTree;
+};
+
+/* Inline implementation */
+
+ExternalControl *FpsPolicy::externalControl() const
+{
+    return m_externalControl.get();
+}
+X11ActiveWindow *FpsPolicy::x11ActiveWindow() const
+{
+    return m_x11ActiveWindow.get();
+}
+X11IdleMonitor *FpsPolicy::x11IdleMonitor() const
+{
+    return m_x11IdleMonitor.get();
+}
+PowerSupply *FpsPolicy::powerSupply() const
+{
+    return m_powerSupply.get();
+}
+ThermalSource *FpsPolicy::thermalSource() const
+{
+    return m_thermalSource.get();
+}
+
+bool FpsPolicy::hasRefreshModes(Tier tier)
+{
+    return (tier == ActiveTier || tier == WindowedTier);
+}
+
+FpsPolicy::Limit FpsPolicy::limit(Tier tier) const
+{
+    return m_limits[tier];
+}
+
+const FpsPolicy::BatteryCurve &FpsPolicy::batteryCurve() const
+{
+    return m_batteryCurve;
+}
+
+const AppRules &FpsPolicy::appRules() const
+{
+    return m_appRules;
+}
+
+quint32 FpsPolicy::settingsId(quint32 nameId) const
+{
+    return (nameId < m_appTable.settingsIds.size())
+        ? m_appTable.settingsIds[nameId]
+        : nameId
+    ;
+}
+
+bool FpsPolicy::isBypass() const
+{
+    return m_bypass;
+}
+
+bool FpsPolicy::inactiveImmediateModeDefault() const
+{
+    return s_inactiveImmediateModeDefault;
+}
@@ -0,0 +1,136 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "InotifyWatcher.hpp"
+
+#include <QSocketNotifier>
+#include <QFile>
+#include <QSet>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+InotifyWatcher::InotifyWatcher()
+    : m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if (m_fd < 0)
+        return;
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &InotifyWatcher::readEvents);
+}
+InotifyWatcher::~InotifyWatcher()
+{
+    if (m_notifier)
+        m_notifier->setEnabled(false);
+    if (m_fd > -1)
+        close(m_fd);
+}
+
+bool InotifyWatcher::addPath(const QString &path)
+{
+    if (m_fd < 0)
+        return false;
+
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(), mask);
+    if (wd < 0)
+        return false;
+
+    m_paths.insert(wd, path);
+    return true;
+}
+void InotifyWatcher::removePath(const QString &path)
+{
+    const int wd = m_paths.key(path, -1);
+    if (wd < 0)
+        return;
+
+    // The descriptor of a moved directory would still report its events
+    inotify_rm_watch(m_fd, wd);
+    m_paths.remove(wd);
+}
+
+void InotifyWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[4096];
+
+    QSet<QString> created;
+    QSet<QString> removed;
+    bool overflow = false;
+
+    for (;;)
+    {
+        const ssize_t size = read(m_fd, buffer, sizeof(buffer));
+        if (size <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            // Events of removed watches, e.g. IN_IGNORED after removePath(), are dropped
+            const auto it = m_paths.constFind(event->wd);
+            if (it == m_paths.constEnd())
+                continue;
+
+            // The watched directory is gone, the caller has to watch it again
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                if (event->mask & IN_IGNORED)
+                    m_paths.erase(it);
+                overflow = true;
+                continue;
+            }
+
+            if ((event->mask & IN_ISDIR) || event->len == 0)
+                continue;
+
+            const auto name = QFile::decodeName(event->name);
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                // Removed and created again, e.g. a replaced FIFO, is reported as both
+                created.insert(name);
+            }
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                if (!created.remove(name))
+                    removed.insert(name);
+            }
+        }
+    }
+
+    if (overflow)
+        emit overflowed();
+    else if (!created.isEmpty() || !removed.isEmpty())
+        emit filesChanged(created.values(), removed.values());
+}
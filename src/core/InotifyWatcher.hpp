@@ -24,48 +24,37 @@
 
 #pragma once
 
-#include "X11Helpers.hpp"
-
-#include <QAbstractNativeEventFilter>
+#include <QStringList>
 #include <QObject>
-#include <QTimer>
+#include <QHash>
+
+class QSocketNotifier;
 
-class X11ActiveWindow : public QObject, public QAbstractNativeEventFilter
+class InotifyWatcher : public QObject
 {
     Q_OBJECT
 
 public:
-    X11ActiveWindow();
-    ~X11ActiveWindow();
+    InotifyWatcher();
+    ~InotifyWatcher();
 
-    inline bool isOk() const;
+    bool addPath(const QString &path);
+    // Must be called before watching a lost path again
+    void removePath(const QString &path);
 
 private:
-    void activeWindowChanged();
-
-private:
-    bool nativeEventFilter(const QByteArray &eventType, void *message, NativeEventFilterResult *result) override;
+    void readEvents();
 
 signals:
-    void activeWindowPidChanged(pid_t pid);
+    // Emitted once per read, file names are relative to the watched directory.
+    // Removed files are meant to be handled before the created ones.
+    void filesChanged(const QStringList &created, const QStringList &removed);
+    // Events were lost or the watched directory is gone
+    void overflowed();
 
 private:
-    xcb_connection_t *const m_conn;
-
-    xcb_atom_t _NET_ACTIVE_WINDOW = 0;
-    xcb_atom_t _NET_WM_PID = 0;
+    const int m_fd;
 
-    bool m_ok = false;
-
-    xcb_window_t m_pevWindow = 0;
-    QTimer m_timer;
-
-    pid_t m_activeWindowPid = 0;
+    QSocketNotifier *m_notifier = nullptr;
+    QHash<int, QString> m_paths; // By watch descriptor
 };
-
-/* Inline implementation */
-
-bool X11ActiveWindow::isOk() const
-{
-    return m_ok;
-}
@@ -0,0 +1,76 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "InstanceLock.hpp"
+
+#include <filesystem>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace std;
+
+InstanceLock::InstanceLock()
+    : m_path(filesystem::temp_directory_path().concat("/" VK_LAYER_FLIMES_GUI_NAME "." + string(getenv("USER") ? getenv("USER") : "")))
+{
+}
+InstanceLock::~InstanceLock()
+{
+    release();
+}
+
+bool InstanceLock::tryLock()
+{
+    if (filesystem::is_fifo(m_path))
+    {
+        const int fd = open(m_path.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd > -1)
+        {
+            close(fd);
+            return false;
+        }
+    }
+    else
+    {
+        error_code ec;
+        filesystem::remove(m_path, ec);
+        mkfifo(m_path.c_str(), 0600);
+    }
+
+    m_fd = open(m_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    return true;
+}
+
+void InstanceLock::release()
+{
+    if (m_fd < 0)
+        return;
+
+    close(m_fd);
+    m_fd = -1;
+
+    error_code ec;
+    filesystem::remove(m_path, ec);
+}
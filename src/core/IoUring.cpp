@@ -0,0 +1,266 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "IoUring.hpp"
+
+#include <QSocketNotifier>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <poll.h>
+
+#ifndef IORING_SQ_CQ_OVERFLOW
+#   define IORING_SQ_CQ_OVERFLOW (1U << 1)
+#endif
+
+using namespace std;
+
+template<typename T>
+static inline T *ringPtr(void *ring, unsigned offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+// "IORING_OP_WRITE" exists since Linux 5.6, older kernels fail every write with EINVAL
+static bool hasWriteOp(int ringFd)
+{
+    constexpr unsigned nOps = 256;
+    vector<char> buffer(sizeof(io_uring_probe) + nOps * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+    if (syscall(SYS_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, nOps) != 0)
+        return false;
+    return (probe->last_op >= IORING_OP_WRITE && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED));
+}
+
+IoUring::IoUring(unsigned entries)
+{
+    io_uring_params params = {};
+
+    m_ringFd = syscall(SYS_io_uring_setup, entries, &params);
+    if (m_ringFd < 0 || !hasWriteOp(m_ringFd))
+        return;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        m_sqRingSize = m_cqRingSize = max(m_sqRingSize, m_cqRingSize);
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED)
+    {
+        m_sqRing = nullptr;
+        return;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        m_cqRing = m_sqRing;
+    }
+    else
+    {
+        m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED)
+        {
+            m_cqRing = nullptr;
+            return;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return;
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    m_sqHead = ringPtr<unsigned>(m_sqRing, params.sq_off.head);
+    m_sqTail = ringPtr<unsigned>(m_sqRing, params.sq_off.tail);
+    m_sqArray = ringPtr<unsigned>(m_sqRing, params.sq_off.array);
+    m_sqFlags = ringPtr<unsigned>(m_sqRing, params.sq_off.flags);
+    m_sqMask = *ringPtr<unsigned>(m_sqRing, params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+
+    m_cqHead = ringPtr<unsigned>(m_cqRing, params.cq_off.head);
+    m_cqTail = ringPtr<unsigned>(m_cqRing, params.cq_off.tail);
+    m_cqes = ringPtr<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    m_cqMask = *ringPtr<unsigned>(m_cqRing, params.cq_off.ring_mask);
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_eventFd < 0)
+        return;
+
+    if (syscall(SYS_io_uring_register, m_ringFd, IORING_REGISTER_EVENTFD, &m_eventFd, 1) != 0)
+        return;
+
+    m_notifier = new QSocketNotifier(m_eventFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &IoUring::reapCompletions);
+
+    m_ok = true;
+}
+IoUring::~IoUring()
+{
+    if (m_notifier)
+        m_notifier->setEnabled(false);
+    if (m_eventFd > -1)
+        close(m_eventFd);
+    if (m_sqes)
+        munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing)
+        munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing)
+        munmap(m_sqRing, m_sqRingSize);
+    if (m_ringFd > -1)
+        close(m_ringFd);
+}
+
+bool IoUring::queueWrite(int fd, const QByteArray &data, quint64 userData)
+{
+    const unsigned tail = *m_sqTail;
+    if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+        return false;
+
+    const unsigned idx = tail & m_sqMask;
+
+    auto sqe = &m_sqes[idx];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<quint64>(data.constData());
+    sqe->len = data.size();
+    sqe->user_data = userData;
+
+    m_sqArray[idx] = idx;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    m_inFlight.insert(userData, data);
+    ++m_toSubmit;
+
+    return true;
+}
+
+bool IoUring::submit()
+{
+    bool flushed = false;
+    while (m_toSubmit > 0)
+    {
+        const int ret = syscall(SYS_io_uring_enter, m_ringFd, m_toSubmit, 0, 0, nullptr, 0);
+        if (ret > 0)
+        {
+            m_toSubmit -= ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        // The completion queue overflowed, make room once and try again
+        if (ret < 0 && errno == EBUSY && !flushed)
+        {
+            if (collectCompletions())
+                QTimer::singleShot(0, this, &IoUring::reapCompletions);
+            flushed = true;
+            continue;
+        }
+
+        break;
+    }
+    return (m_toSubmit == 0);
+}
+
+void IoUring::waitForCompletions(int timeout)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    submit();
+    reapCompletions();
+
+    while (!m_inFlight.isEmpty())
+    {
+        const int remaining = timeout - elapsed.elapsed();
+        if (remaining <= 0)
+        {
+            qWarning() << "io_uring writes didn't complete in time:" << m_inFlight.size();
+            break;
+        }
+
+        pollfd pfd = {m_eventFd, POLLIN, 0};
+        if (poll(&pfd, 1, remaining) < 0 && errno != EINTR)
+            break;
+
+        submit();
+        reapCompletions();
+    }
+}
+
+bool IoUring::collectCompletions()
+{
+    const size_t count = m_completions.size();
+    for (;;)
+    {
+        unsigned head = *m_cqHead;
+        const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const auto &cqe = m_cqes[head & m_cqMask];
+            m_completions.emplace_back(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+        // Completions which didn't fit are kept by the kernel until asked for
+        if (!(__atomic_load_n(m_sqFlags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW))
+            break;
+        if (syscall(SYS_io_uring_enter, m_ringFd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+            break;
+    }
+    return (m_completions.size() > count);
+}
+
+void IoUring::reapCompletions()
+{
+    quint64 counter = 0;
+    if (read(m_eventFd, &counter, sizeof(counter)) < 0)
+        counter = 0;
+
+    collectCompletions();
+
+    vector<pair<quint64, int>> completions;
+    completions.swap(m_completions);
+
+    for (auto &&completion : completions)
+    {
+        m_inFlight.remove(completion.first);
+        emit writeCompleted(completion.first, completion.second);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QHash>
+
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+class QSocketNotifier;
+
+class IoUring : public QObject
+{
+    Q_OBJECT
+
+public:
+    IoUring(unsigned entries);
+    ~IoUring();
+
+    inline bool isOk() const;
+
+    // Returns false if the submission queue is full, call "submit()" and try again
+    bool queueWrite(int fd, const QByteArray &data, quint64 userData);
+
+    // Returns false if some queued writes couldn't be submitted
+    bool submit();
+    void waitForCompletions(int timeout = 1000); // ms
+
+private:
+    bool collectCompletions();
+    void reapCompletions();
+
+signals:
+    void writeCompleted(quint64 userData, int result);
+
+private:
+    bool m_ok = false;
+
+    int m_ringFd = -1;
+    int m_eventFd = -1;
+
+    void *m_sqRing = nullptr;
+    void *m_cqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned *m_sqHead = nullptr;
+    unsigned *m_sqTail = nullptr;
+    unsigned *m_sqArray = nullptr;
+    unsigned *m_sqFlags = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+
+    unsigned *m_cqHead = nullptr;
+    unsigned *m_cqTail = nullptr;
+    io_uring_cqe *m_cqes = nullptr;
+    unsigned m_cqMask = 0;
+
+    unsigned m_toSubmit = 0;
+
+    std::vector<std::pair<quint64, int>> m_completions; // Collected, but not emitted yet
+
+    QHash<quint64, QByteArray> m_inFlight; // Buffers must stay alive until completion
+
+    QSocketNotifier *m_notifier = nullptr;
+};
+
+/* Inline implementation */
+
+bool IoUring::isOk() const
+{
+    return m_ok;
+}
@@ -0,0 +1,226 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "PowerSupply.hpp"
+
+#include <QSocketNotifier>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+PowerSupply::PowerSupply()
+    : m_udev(udev_new())
+{
+    if (!m_udev)
+        return;
+
+    m_monitor = udev_monitor_new_from_netlink(m_udev, "udev");
+    if (!m_monitor)
+        return;
+
+    // Let the kernel drop events from other subsystems
+    if (udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "power_supply", nullptr) != 0)
+        return;
+
+    if (udev_monitor_enable_receiving(m_monitor) != 0)
+        return;
+
+    const int fd = udev_monitor_get_fd(m_monitor);
+    if (fd < 0)
+        return;
+
+    m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &PowerSupply::socketActivated);
+
+    m_batteryStateTimer.setInterval(60 * 1000);
+    connect(&m_batteryStateTimer, &QTimer::timeout,
+            this, &PowerSupply::checkBattery);
+
+    m_ok = true;
+
+    enumerateSupplies();
+
+    QTimer::singleShot(0, this, &PowerSupply::checkBattery);
+}
+PowerSupply::~PowerSupply()
+{
+    closeSupplies();
+    if (m_notifier)
+        m_notifier->setEnabled(false);
+    if (m_monitor)
+        udev_monitor_unref(m_monitor);
+    if (m_udev)
+        udev_unref(m_udev);
+}
+
+QByteArray PowerSupply::readFile(int fd)
+{
+    if (fd < 0)
+        return QByteArray();
+
+    char buffer[64];
+    const ssize_t size = pread(fd, buffer, sizeof(buffer), 0);
+    if (size <= 0)
+        return QByteArray();
+
+    return QByteArray(buffer, size).trimmed().toLower();
+}
+
+void PowerSupply::enumerateSupplies()
+{
+    closeSupplies();
+
+    auto enumerate = udev_enumerate_new(m_udev);
+    if (!enumerate)
+        return;
+
+    udev_enumerate_add_match_subsystem(enumerate, "power_supply");
+    udev_enumerate_scan_devices(enumerate);
+
+    udev_list_entry *entry = nullptr;
+    udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate))
+    {
+        const QByteArray sysPath = udev_list_entry_get_name(entry);
+
+        auto openAttr = [&](const char *name) {
+            return open((sysPath + "/" + name).constData(), O_RDONLY | O_CLOEXEC);
+        };
+
+        const int typeFd = openAttr("type");
+        const int scopeFd = openAttr("scope");
+        const auto type = readFile(typeFd);
+        const auto scope = readFile(scopeFd);
+        if (typeFd > -1)
+            close(typeFd);
+        if (scopeFd > -1)
+            close(scopeFd);
+
+        Supply supply;
+        if (type == "battery")
+        {
+            if (scope.isEmpty() || scope == "system")
+            {
+                supply.isSystemBattery = true;
+                supply.capacityFd = openAttr("capacity");
+                supply.statusFd = openAttr("status");
+            }
+            else
+            {
+                continue;
+            }
+        }
+        else
+        {
+            supply.onlineFd = openAttr("online");
+            if (supply.onlineFd < 0)
+                continue;
+        }
+        m_supplies.push_back(supply);
+    }
+
+    udev_enumerate_unref(enumerate);
+}
+void PowerSupply::closeSupplies()
+{
+    for (auto &&supply : m_supplies)
+    {
+        for (int fd : {supply.onlineFd, supply.capacityFd, supply.statusFd})
+        {
+            if (fd > -1)
+                close(fd);
+        }
+    }
+    m_supplies.clear();
+}
+
+void PowerSupply::socketActivated()
+{
+    // Drain all pending events and check once
+    bool rescan = false;
+    bool changed = false;
+    while (auto dev = udev_monitor_receive_device(m_monitor))
+    {
+        const QByteArray action = udev_device_get_action(dev);
+        if (action == "add" || action == "remove")
+            rescan = true;
+        changed = true;
+
+        udev_device_unref(dev);
+    }
+
+    if (rescan)
+        enumerateSupplies();
+    if (changed)
+        checkBattery();
+}
+
+void PowerSupply::checkBattery()
+{
+    bool hasBattery = false;
+    bool isOnline = false;
+    int capacity = -1;
+    QByteArray status;
+
+    for (auto &&supply : m_supplies)
+    {
+        if (supply.isSystemBattery)
+        {
+            hasBattery = true;
+
+            bool ok = false;
+            const int batteryCapacity = readFile(supply.capacityFd).toInt(&ok);
+            if (ok && (capacity < 0 || batteryCapacity < capacity))
+            {
+                capacity = batteryCapacity;
+                status = readFile(supply.statusFd);
+            }
+        }
+        else
+        {
+            const auto online = readFile(supply.onlineFd);
+            if (!online.isEmpty() && online != "0")
+                isOnline = true;
+        }
+    }
+
+    const bool isBattery = (hasBattery && !isOnline);
+
+    if (m_isBattery != isBattery)
+    {
+        m_isBattery = isBattery;
+        if (m_isBattery)
+            m_batteryStateTimer.start();
+        else
+            m_batteryStateTimer.stop();
+        emit powerSourceChanged();
+    }
+
+    if (m_capacity != capacity || m_status != status)
+    {
+        m_capacity = capacity;
+        m_status = status;
+        emit batteryStateChanged();
+    }
+}
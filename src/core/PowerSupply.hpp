@@ -24,16 +24,28 @@
 
 #pragma once
 
-#include <QObject>
+#include <QTimer>
 
 #include <libudev.h>
 
+#include <vector>
+
 class QSocketNotifier;
 
 class PowerSupply : public QObject
 {
     Q_OBJECT
 
+    struct Supply
+    {
+        bool isSystemBattery = false; // "type" and "scope" don't change
+
+        // Attribute files kept open and re-read using "pread()"
+        int onlineFd = -1;
+        int capacityFd = -1;
+        int statusFd = -1;
+    };
+
 public:
     PowerSupply();
     ~PowerSupply();
@@ -42,8 +54,15 @@ public:
 
     inline bool isBattery() const;
 
+    // System battery state, "capacity" is -1 if unknown, "status" is lower case as in sysfs
+    inline int capacity() const;
+    inline QByteArray status() const;
+
 private:
-    QByteArray readFile(const QString &path) const;
+    static QByteArray readFile(int fd);
+
+    void enumerateSupplies();
+    void closeSupplies();
 
     void socketActivated();
 
@@ -51,16 +70,24 @@ private:
 
 signals:
     void powerSourceChanged();
+    void batteryStateChanged();
 
 private:
     bool m_ok = false;
 
     bool m_isBattery = false;
 
+    int m_capacity = -1;
+    QByteArray m_status;
+
+    QTimer m_batteryStateTimer; // Not all batteries send events on capacity change
+
     udev *const m_udev;
     udev_monitor *m_monitor = nullptr;
 
     QSocketNotifier *m_notifier = nullptr;
+
+    std::vector<Supply> m_supplies;
 };
 
 /* Inline implementation */
@@ -74,3 +101,12 @@ bool PowerSupply::isBattery() const
 {
     return m_isBattery;
 }
+
+int PowerSupply::capacity() const
+{
+    return m_capacity;
+}
+QByteArray PowerSupply::status() const
+{
+    return m_status;
+}
@@ -0,0 +1,180 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "ProcessTree.hpp"
+
+#include <QFile>
+
+#include <unistd.h>
+
+#include <algorithm>
+
+using namespace std;
+
+ProcessTree::ProcessTree()
+{
+    m_selfPgid = getpgrp();
+    for (pid_t pid = getppid(); pid > 1; )
+    {
+        m_selfAncestors.insert(pid);
+
+        auto selfAncestor = process(pid);
+        if (!selfAncestor)
+            break;
+        pid = selfAncestor->ppid;
+    }
+}
+ProcessTree::~ProcessTree()
+{
+}
+
+optional<ProcessTree::Process> ProcessTree::process(pid_t pid)
+{
+    if (pid <= 0)
+        return {};
+
+    auto it = m_processes.constFind(pid);
+    if (it != m_processes.constEnd())
+        return it.value();
+
+    Process process;
+    if (!readProcess(pid, process))
+        return {};
+
+    m_processes.insert(pid, process);
+    return process;
+}
+
+void ProcessTree::update(pid_t pid)
+{
+    Process process;
+    if (pid > 0 && readProcess(pid, process))
+        m_processes.insert(pid, process);
+    else
+        m_processes.remove(pid);
+}
+
+void ProcessTree::remove(pid_t pid)
+{
+    m_processes.remove(pid);
+}
+
+void ProcessTree::setWindowOwners(const QSet<pid_t> &windowOwners)
+{
+    m_windowOwners = windowOwners;
+}
+
+bool ProcessTree::isRelated(pid_t pid, pid_t windowPid)
+{
+    if (pid <= 0 || windowPid <= 0)
+        return false;
+    if (pid == windowPid)
+        return true;
+
+    // Applications with own windows are tracked by them
+    if (m_windowOwners.contains(pid))
+        return false;
+
+    const auto proc = process(pid);
+    const auto windowProc = process(windowPid);
+    if (!proc || !windowProc || proc->pgid != windowProc->pgid || proc->pgid == m_selfPgid)
+        return false;
+
+    // The window process is an ancestor of the application
+    const auto appAncestors = ancestors(pid);
+    for (auto &&ancestor : appAncestors)
+    {
+        if (ancestor == windowPid)
+            return true;
+    }
+
+    // The application is an ancestor of the window process or both share one without windows
+    for (auto &&ancestor : ancestors(windowPid))
+    {
+        if (ancestor == pid)
+            return true;
+        if (m_windowOwners.contains(ancestor))
+            break;
+        if (find(appAncestors.begin(), appAncestors.end(), ancestor) != appAncestors.end())
+            return true;
+    }
+
+    return false;
+}
+
+bool ProcessTree::readProcess(pid_t pid, Process &process)
+{
+    QFile f(QString("/proc/%1/stat").arg(pid));
+    if (!f.open(QFile::ReadOnly))
+        return false;
+
+    // The command name can contain spaces and parentheses
+    const auto stat = f.readAll();
+    const int commEnd = stat.lastIndexOf(')');
+    if (commEnd < 0)
+        return false;
+
+    // Fields after the command name: state, ppid, pgrp, ..., starttime (22nd field)
+    const auto fields = stat.mid(commEnd + 2).split(' ');
+    if (fields.size() < 20)
+        return false;
+
+    process.ppid = fields[1].toInt();
+    process.pgid = fields[2].toInt();
+    process.startTime = fields[19].toULongLong();
+    return true;
+}
+
+vector<pid_t> ProcessTree::ancestors(pid_t pid)
+{
+    vector<pid_t> result;
+
+    auto proc = process(pid);
+    if (!proc)
+        return result;
+
+    const pid_t pgid = proc->pgid;
+
+    // Bounded in case of a cycle caused by a reused PID
+    for (int depth = 0; depth < 64; ++depth)
+    {
+        const pid_t ppid = proc->ppid;
+        if (ppid <= 1 || m_selfAncestors.contains(ppid))
+            break;
+
+        const auto parent = process(ppid);
+        if (!parent || parent->pgid != pgid)
+            break;
+        if (parent->startTime > proc->startTime)
+            break; // Reused PID, not the real parent
+
+        result.push_back(ppid);
+        if (m_windowOwners.contains(ppid))
+            break;
+
+        proc = parent;
+    }
+
+    return result;
+}
@@ -0,0 +1,78 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+
+#include <sys/types.h>
+
+#include <optional>
+#include <vector>
+
+// Cached parent and process group relations read from "/proc/<pid>/stat"
+class ProcessTree
+{
+public:
+    struct Process
+    {
+        pid_t ppid = 0;
+        pid_t pgid = 0;
+        quint64 startTime = 0; // Clock ticks since boot, detects reused PIDs
+    };
+
+public:
+    ProcessTree();
+    ~ProcessTree();
+
+    std::optional<Process> process(pid_t pid);
+
+    // Re-reads the process, e.g. its PID might have been reused or it has been reparented
+    void update(pid_t pid);
+    // Forgets the process, e.g. when it exits
+    void remove(pid_t pid);
+
+    // Processes which own top-level windows, they end the relation chains
+    void setWindowOwners(const QSet<pid_t> &windowOwners);
+
+    // True if both processes are in the same process group and are linked by a
+    // parent chain within it, like Wine and Proton processes. Processes which own
+    // windows break the chain, so launchers, terminals and shells don't relate
+    // everything they started. This process group and its ancestors are ignored.
+    bool isRelated(pid_t pid, pid_t windowPid);
+
+private:
+    static bool readProcess(pid_t pid, Process &process);
+
+    // Ancestors of "pid" in its process group, up to the first window owner
+    std::vector<pid_t> ancestors(pid_t pid);
+
+private:
+    QHash<pid_t, Process> m_processes;
+    QSet<pid_t> m_windowOwners;
+
+    QSet<pid_t> m_selfAncestors;
+    pid_t m_selfPgid = 0;
+};
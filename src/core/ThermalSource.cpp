@@ -0,0 +1,130 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "ThermalSource.hpp"
+
+#include <QFile>
+#include <QDir>
+
+#include <cmath>
+
+ThermalSource::ThermalSource()
+{
+    m_pollTimer.setInterval(1000);
+
+    connect(&m_pollTimer, &QTimer::timeout,
+            this, &ThermalSource::poll);
+
+    setSysfsRoot(s_defaultSysfsRoot);
+}
+ThermalSource::~ThermalSource()
+{
+}
+
+void ThermalSource::setSysfsRoot(const QString &sysfsRoot)
+{
+    if (m_sysfsRoot == sysfsRoot)
+        return;
+
+    m_sysfsRoot = sysfsRoot;
+    m_tempFiles.clear();
+
+    const QDir dir(m_sysfsRoot);
+    for (auto &&zone : dir.entryList({"thermal_zone*"}, QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        const auto tempFile = dir.filePath(zone + "/temp");
+        if (QFile::exists(tempFile))
+            m_tempFiles.push_back(tempFile);
+    }
+
+    setEnabled(m_enabled);
+}
+
+void ThermalSource::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    m_integral = 0.0;
+
+    if (m_enabled && isOk())
+    {
+        m_pollTimer.start();
+        poll();
+    }
+    else
+    {
+        m_pollTimer.stop();
+        m_temperature = 0.0;
+        setScale(1.0);
+    }
+}
+
+void ThermalSource::setCeiling(double ceiling)
+{
+    m_ceiling = ceiling;
+}
+
+void ThermalSource::poll()
+{
+    double temperature = 0.0;
+    bool hasTemperature = false;
+    for (auto &&tempFile : m_tempFiles)
+    {
+        QFile f(tempFile);
+        if (!f.open(QFile::ReadOnly))
+            continue;
+
+        bool ok = false;
+        const double value = f.readAll().trimmed().toLongLong(&ok) / 1000.0; // Millidegrees Celsius
+        if (!ok)
+            continue;
+
+        temperature = hasTemperature ? qMax(temperature, value) : value;
+        hasTemperature = true;
+    }
+    if (!hasTemperature)
+        return;
+
+    m_temperature = temperature;
+
+    // The proportional term follows the current error, the integral one keeps throttling
+    // harder while the temperature stays above the target and restores gradually below it
+    const double maxIntegral = (1.0 - s_minScale) / s_gainI;
+    const double error = m_temperature - (m_ceiling - s_margin);
+    if (m_temperature >= m_ceiling)
+        m_integral = maxIntegral;
+    else
+        m_integral = qBound(0.0, m_integral + error, maxIntegral);
+
+    setScale(qBound(s_minScale, 1.0 - s_gainP * error - s_gainI * m_integral, 1.0));
+}
+
+void ThermalSource::setScale(double scale)
+{
+    // Ignore tiny changes, they would only cause redundant FIFO writes
+    if (std::abs(scale - m_scale) < 0.01 && (scale < 1.0 || m_scale == 1.0))
+        return;
+
+    m_scale = scale;
+    emit scaleChanged();
+}
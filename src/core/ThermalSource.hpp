@@ -0,0 +1,114 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <QStringList>
+#include <QTimer>
+
+class ThermalSource : public QObject
+{
+    Q_OBJECT
+
+    static constexpr double s_margin = 5.0; // Throttling keeps the temperature this many degrees below the ceiling
+    static constexpr double s_gainP = 0.05; // Per degree
+    static constexpr double s_gainI = 0.01; // Per degree and poll
+    static constexpr double s_minScale = 0.25;
+
+public:
+    static constexpr const char *s_defaultSysfsRoot = "/sys/class/thermal";
+
+    ThermalSource();
+    ~ThermalSource();
+
+    inline bool isOk() const;
+
+    inline QString sysfsRoot() const;
+    void setSysfsRoot(const QString &sysfsRoot);
+
+    inline bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    inline double ceiling() const;
+    void setCeiling(double ceiling);
+
+    inline double temperature() const;
+
+    // Factor (0.25 - 1.0) to apply on FPS limits
+    inline double scale() const;
+
+    // Reads the temperature and updates the scale, called every second while enabled
+    void poll();
+
+private:
+    void setScale(double scale);
+
+signals:
+    void scaleChanged();
+
+private:
+    QString m_sysfsRoot;
+    QStringList m_tempFiles;
+
+    QTimer m_pollTimer;
+
+    bool m_enabled = false;
+    double m_ceiling = 85.0;
+
+    double m_temperature = 0.0;
+    double m_integral = 0.0; // Accumulated degrees above the target
+    double m_scale = 1.0;
+};
+
+/* Inline implementation */
+
+bool ThermalSource::isOk() const
+{
+    return !m_tempFiles.isEmpty();
+}
+
+QString ThermalSource::sysfsRoot() const
+{
+    return m_sysfsRoot;
+}
+
+bool ThermalSource::isEnabled() const
+{
+    return m_enabled;
+}
+
+double ThermalSource::ceiling() const
+{
+    return m_ceiling;
+}
+
+double ThermalSource::temperature() const
+{
+    return m_temperature;
+}
+
+double ThermalSource::scale() const
+{
+    return m_scale;
+}
@@ -0,0 +1,641 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "X11ActiveWindow.hpp"
+
+#include <QSocketNotifier>
+#include <QByteArray>
+#include <QDebug>
+
+#include <xcb/xcbext.h>
+#ifdef USE_XCB_RES
+#   include <xcb/res.h>
+#endif
+#ifdef USE_XCB_RANDR
+#   include <xcb/randr.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+X11ActiveWindow::X11ActiveWindow()
+{
+    // Own connection, so it works without QtGui and never blocks the GUI connection
+    int screenNum = 0;
+    m_conn = xcb_connect(nullptr, &screenNum);
+    if (xcb_connection_has_error(m_conn))
+        return;
+
+    auto screenIt = xcb_setup_roots_iterator(xcb_get_setup(m_conn));
+    for (; screenIt.rem > 0 && screenNum > 0; --screenNum)
+        xcb_screen_next(&screenIt);
+    if (screenIt.rem == 0)
+        return;
+    m_root = screenIt.data->root;
+
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(m_conn, m_root, XCB_CW_EVENT_MASK, &mask);
+
+    const struct
+    {
+        QByteArray name;
+        xcb_atom_t *atom;
+    } atoms[] {
+        {"_NET_ACTIVE_WINDOW", &_NET_ACTIVE_WINDOW},
+        {"_NET_WM_PID", &_NET_WM_PID},
+        {"_NET_CLIENT_LIST", &_NET_CLIENT_LIST},
+        {"_NET_WM_STATE", &_NET_WM_STATE},
+        {"_NET_WM_STATE_HIDDEN", &_NET_WM_STATE_HIDDEN},
+        {"_NET_WM_STATE_FULLSCREEN", &_NET_WM_STATE_FULLSCREEN},
+        {"WM_STATE", &WM_STATE},
+    };
+    std::vector<xcb_intern_atom_cookie_t> atomCookies;
+    for (auto &&atom : atoms)
+        atomCookies.push_back(xcb_intern_atom(m_conn, true, atom.name.length(), atom.name.constData()));
+    for (size_t i = 0; i < atomCookies.size(); ++i)
+    {
+        if (auto atomReply = managePtr(xcb_intern_atom_reply(m_conn, atomCookies[i], nullptr)))
+            *atoms[i].atom = atomReply->atom;
+    }
+
+#ifdef USE_XCB_RES
+    // "QueryClientIds" requires X-Resource 1.2
+    auto resExt = xcb_get_extension_data(m_conn, &xcb_res_id);
+    if (resExt && resExt->present)
+    {
+        if (auto versionReply = XCB_CALL(xcb_res_query_version, m_conn, 1, 2))
+            m_hasXRes = (versionReply->server_major > 1 || (versionReply->server_major == 1 && versionReply->server_minor >= 2));
+    }
+#endif
+
+#ifdef USE_XCB_RANDR
+    auto randrExt = xcb_get_extension_data(m_conn, &xcb_randr_id);
+    if (randrExt && randrExt->present)
+    {
+        // "GetScreenResourcesCurrent" requires RandR 1.3
+        if (auto versionReply = XCB_CALL(xcb_randr_query_version, m_conn, 1, 3))
+            m_hasRandR = (versionReply->major_version > 1 || (versionReply->major_version == 1 && versionReply->minor_version >= 3));
+    }
+    if (m_hasRandR)
+    {
+        m_randrFirstEvent = randrExt->first_event;
+        xcb_randr_select_input(m_conn, m_root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE);
+    }
+#endif
+
+    m_notifier = new QSocketNotifier(xcb_get_file_descriptor(m_conn), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &X11ActiveWindow::processEvents);
+
+    // Get the initial active window and top-level windows
+    requestActiveWindow();
+    if (_NET_CLIENT_LIST != 0)
+        requestClientList();
+    if (m_hasRandR)
+        requestScreenResources();
+
+    xcb_flush(m_conn);
+
+    m_ok = true;
+}
+X11ActiveWindow::~X11ActiveWindow()
+{
+    if (m_notifier)
+        m_notifier->setEnabled(false);
+    if (m_conn)
+        xcb_disconnect(m_conn);
+}
+
+void X11ActiveWindow::requestActiveWindow()
+{
+    const auto cookie = xcb_get_property(m_conn, false, m_root, _NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 0, 1);
+    m_pendingReplies.push_back({PendingReply::ActiveWindow, cookie.sequence, m_root});
+}
+void X11ActiveWindow::requestWindowPid(xcb_window_t window)
+{
+    // Subscribe first, so no "_NET_WM_PID" change or destruction can be missed
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_change_window_attributes(m_conn, window, XCB_CW_EVENT_MASK, &mask);
+
+    const auto cookie = xcb_get_property(m_conn, false, window, _NET_WM_PID, XCB_ATOM_CARDINAL, 0, 1);
+    m_pendingReplies.push_back({PendingReply::WindowPid, cookie.sequence, window});
+}
+void X11ActiveWindow::requestClientList()
+{
+    const auto cookie = xcb_get_property(m_conn, false, m_root, _NET_CLIENT_LIST, XCB_ATOM_WINDOW, 0, ~0);
+    m_pendingReplies.push_back({PendingReply::ClientList, cookie.sequence, m_root});
+}
+void X11ActiveWindow::requestWindowStates(xcb_window_t window)
+{
+    if (_NET_WM_STATE != 0)
+    {
+        const auto cookie = xcb_get_property(m_conn, false, window, _NET_WM_STATE, XCB_ATOM_ATOM, 0, ~0);
+        m_pendingReplies.push_back({PendingReply::WindowNetState, cookie.sequence, window});
+    }
+    if (WM_STATE != 0)
+    {
+        const auto cookie = xcb_get_property(m_conn, false, window, WM_STATE, WM_STATE, 0, 1);
+        m_pendingReplies.push_back({PendingReply::WindowWmState, cookie.sequence, window});
+    }
+}
+
+void X11ActiveWindow::requestActiveWindowGeometry()
+{
+    const auto geometryCookie = xcb_get_geometry(m_conn, m_activeWindow);
+    m_pendingReplies.push_back({PendingReply::WindowGeometry, geometryCookie.sequence, m_activeWindow});
+
+    const auto positionCookie = xcb_translate_coordinates(m_conn, m_activeWindow, m_root, 0, 0);
+    m_pendingReplies.push_back({PendingReply::WindowPosition, positionCookie.sequence, m_activeWindow});
+}
+void X11ActiveWindow::requestScreenResources()
+{
+#ifdef USE_XCB_RANDR
+    const auto cookie = xcb_randr_get_screen_resources_current(m_conn, m_root);
+    m_pendingReplies.push_back({PendingReply::ScreenResources, cookie.sequence, m_root});
+#endif
+}
+
+bool X11ActiveWindow::isPidPending(xcb_window_t window) const
+{
+    return std::any_of(m_pendingReplies.begin(), m_pendingReplies.end(), [=](const PendingReply &pendingReply) {
+        return ((pendingReply.type == PendingReply::WindowPid || pendingReply.type == PendingReply::WindowClientPid) && pendingReply.window == window);
+    });
+}
+void X11ActiveWindow::requestWindowClientPid(xcb_window_t window)
+{
+#ifdef USE_XCB_RES
+    xcb_res_client_id_spec_t spec;
+    spec.client = window;
+    spec.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID;
+
+    const auto cookie = xcb_res_query_client_ids(m_conn, 1, &spec);
+    m_pendingReplies.push_back({PendingReply::WindowClientPid, cookie.sequence, window});
+#else
+    Q_UNUSED(window)
+#endif
+}
+
+void X11ActiveWindow::setActiveWindow(xcb_window_t window)
+{
+    m_activeWindow = window;
+
+    if (m_activeWindow == 0)
+    {
+        setActiveWindowFullscreen(false);
+        setActiveWindowPid(0);
+        return;
+    }
+
+    if (m_hasRandR)
+        requestActiveWindowGeometry();
+
+    // Client windows have the state cached, other windows have it requested once
+    auto clientIt = m_clientWindows.constFind(m_activeWindow);
+    if (clientIt != m_clientWindows.constEnd())
+    {
+        setActiveWindowFullscreen(clientIt->fullscreen);
+    }
+    else
+    {
+        setActiveWindowFullscreen(false);
+        requestWindowStates(m_activeWindow);
+    }
+
+    auto it = m_windowPids.constFind(m_activeWindow);
+    if (it != m_windowPids.constEnd())
+    {
+        setActiveWindowPid(it.value());
+        return;
+    }
+
+    if (!isPidPending(m_activeWindow))
+        requestWindowPid(m_activeWindow);
+}
+void X11ActiveWindow::setActiveWindowPid(pid_t pid)
+{
+    if (m_activeWindowPid != pid)
+    {
+        m_activeWindowPid = pid;
+        emit activeWindowPidChanged(m_activeWindowPid);
+    }
+}
+void X11ActiveWindow::setActiveWindowFullscreen(bool fullscreen)
+{
+    if (m_activeWindowFullscreen != fullscreen)
+    {
+        m_activeWindowFullscreen = fullscreen;
+        emit activeWindowFullscreenChanged();
+    }
+}
+void X11ActiveWindow::windowPidResolved(xcb_window_t window, pid_t pid, bool cache)
+{
+    if (cache)
+        m_windowPids[window] = pid;
+    if (window == m_activeWindow)
+        setActiveWindowPid(pid);
+    if (m_clientWindows.contains(window))
+        m_clientWindowsChanged = true;
+}
+
+void X11ActiveWindow::setClientList(const xcb_window_t *windows, int count)
+{
+    QSet<xcb_window_t> clientWindows;
+    for (int i = 0; i < count; ++i)
+        clientWindows.insert(windows[i]);
+
+    for (auto it = m_clientWindows.begin(); it != m_clientWindows.end();)
+    {
+        if (!clientWindows.contains(it.key()))
+        {
+            it = m_clientWindows.erase(it);
+            m_clientWindowsChanged = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto &&window : clientWindows)
+    {
+        if (m_clientWindows.contains(window))
+            continue;
+
+        m_clientWindows.insert(window, ClientWindow());
+        m_clientWindowsChanged = true;
+
+        if (!m_windowPids.contains(window) && !isPidPending(window))
+            requestWindowPid(window); // Also subscribes to property changes
+        requestWindowStates(window);
+    }
+}
+void X11ActiveWindow::updateHiddenPids()
+{
+    m_clientWindowsChanged = false;
+
+    QSet<pid_t> hiddenPids;
+    QSet<pid_t> visiblePids;
+    for (auto it = m_clientWindows.constBegin(), itEnd = m_clientWindows.constEnd(); it != itEnd; ++it)
+    {
+        const pid_t pid = m_windowPids.value(it.key());
+        if (pid == 0)
+            continue;
+
+        if (it->netHidden || it->iconic)
+            hiddenPids.insert(pid);
+        else
+            visiblePids.insert(pid);
+    }
+    hiddenPids.subtract(visiblePids);
+
+    if (m_hiddenPids != hiddenPids || m_visiblePids != visiblePids)
+    {
+        m_hiddenPids = hiddenPids;
+        m_visiblePids = visiblePids;
+        emit hiddenPidsChanged();
+    }
+}
+
+void X11ActiveWindow::updateActiveRefreshRate()
+{
+    // The monitor which shows the biggest part of the active window
+    double refreshRate = 0.0;
+    int maxArea = 0;
+    for (auto &&crtc : m_crtcs)
+    {
+        const auto intersected = crtc.rect.intersected(m_activeWindowRect);
+        const int area = intersected.width() * intersected.height();
+        if (area > maxArea)
+        {
+            maxArea = area;
+            refreshRate = crtc.refreshRate;
+        }
+    }
+    if (refreshRate == 0.0 && !m_crtcs.empty())
+        refreshRate = m_crtcs.front().refreshRate;
+
+    if (!qFuzzyCompare(m_activeRefreshRate, refreshRate))
+    {
+        m_activeRefreshRate = refreshRate;
+        emit activeRefreshRateChanged();
+    }
+}
+
+void X11ActiveWindow::processEvents()
+{
+    // Collecting replies can read more events and vice versa
+    for (;;)
+    {
+        bool progress = false;
+        while (auto gev = managePtr(xcb_poll_for_event(m_conn)))
+        {
+            handleEvent(gev.get());
+            progress = true;
+        }
+        if (processReplies())
+            progress = true;
+        if (!progress)
+            break;
+    }
+
+    if (m_clientWindowsChanged)
+        updateHiddenPids();
+
+    xcb_flush(m_conn);
+
+    if (xcb_connection_has_error(m_conn))
+    {
+        qWarning() << "X11 connection error, active window tracking is disabled";
+        m_notifier->setEnabled(false);
+        m_pendingReplies.clear();
+    }
+}
+void X11ActiveWindow::handleEvent(xcb_generic_event_t *gev)
+{
+    const uint8_t responseType = (gev->response_type & ~0x80);
+
+#ifdef USE_XCB_RANDR
+    if (m_hasRandR && (responseType == m_randrFirstEvent + XCB_RANDR_SCREEN_CHANGE_NOTIFY || responseType == m_randrFirstEvent + XCB_RANDR_NOTIFY))
+    {
+        requestScreenResources();
+        return;
+    }
+#endif
+
+    switch (responseType)
+    {
+        case XCB_PROPERTY_NOTIFY:
+        {
+            auto pev = reinterpret_cast<xcb_property_notify_event_t *>(gev);
+            if (pev->window == m_root)
+            {
+                if (pev->atom == _NET_ACTIVE_WINDOW)
+                    requestActiveWindow();
+                else if (pev->atom == _NET_CLIENT_LIST)
+                    requestClientList();
+            }
+            else if (pev->atom == _NET_WM_PID)
+            {
+                m_windowPids.remove(pev->window);
+                if (pev->window == m_activeWindow || m_clientWindows.contains(pev->window))
+                    requestWindowPid(pev->window);
+                if (m_clientWindows.contains(pev->window))
+                    m_clientWindowsChanged = true;
+            }
+            else if ((pev->atom == _NET_WM_STATE || pev->atom == WM_STATE) && (pev->window == m_activeWindow || m_clientWindows.contains(pev->window)))
+            {
+                requestWindowStates(pev->window);
+            }
+            break;
+        }
+        case XCB_DESTROY_NOTIFY:
+        {
+            auto dev = reinterpret_cast<xcb_destroy_notify_event_t *>(gev);
+            m_windowPids.remove(dev->window);
+            if (m_clientWindows.remove(dev->window) > 0)
+                m_clientWindowsChanged = true;
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY:
+        {
+            auto cev = reinterpret_cast<xcb_configure_notify_event_t *>(gev);
+            if (m_hasRandR && cev->window == m_activeWindow)
+                requestActiveWindowGeometry();
+            break;
+        }
+    }
+}
+bool X11ActiveWindow::processReplies()
+{
+    bool progress = false;
+    while (!m_pendingReplies.empty())
+    {
+        const auto pendingReply = m_pendingReplies.front();
+
+        void *reply = nullptr;
+        xcb_generic_error_t *error = nullptr;
+        if (xcb_poll_for_reply(m_conn, pendingReply.sequence, &reply, &error) == 0)
+            break;
+
+        m_pendingReplies.pop_front();
+        progress = true;
+
+        free(error); // E.g. "BadWindow" if the window has been destroyed meanwhile
+        handleReply(pendingReply, managePtr(reply).get());
+    }
+    return progress;
+}
+void X11ActiveWindow::handleReply(const PendingReply &pendingReply, void *reply)
+{
+    auto propertyValue = [](void *reply) -> uint32_t {
+        auto propertyReply = static_cast<xcb_get_property_reply_t *>(reply);
+        if (!propertyReply || propertyReply->type == 0 || xcb_get_property_value_length(propertyReply) < 4)
+            return 0;
+        return reinterpret_cast<uint32_t *>(xcb_get_property_value(propertyReply))[0];
+    };
+
+    switch (pendingReply.type)
+    {
+        case PendingReply::ActiveWindow:
+        {
+            // Only the newest active window matters
+            const bool newer = std::none_of(m_pendingReplies.begin(), m_pendingReplies.end(), [](const PendingReply &other) {
+                return (other.type == PendingReply::ActiveWindow);
+            });
+            if (newer)
+                setActiveWindow(propertyValue(reply));
+            break;
+        }
+        case PendingReply::WindowPid:
+        {
+            const pid_t pid = propertyValue(reply);
+            if (pid == 0 && reply && m_hasXRes)
+                requestWindowClientPid(pendingReply.window);
+            else
+                windowPidResolved(pendingReply.window, pid, reply != nullptr);
+            break;
+        }
+        case PendingReply::WindowClientPid:
+        {
+            pid_t pid = 0;
+#ifdef USE_XCB_RES
+            if (auto idsReply = static_cast<xcb_res_query_client_ids_reply_t *>(reply))
+            {
+                for (auto it = xcb_res_query_client_ids_ids_iterator(idsReply); it.rem > 0; xcb_res_client_id_value_next(&it))
+                {
+                    if ((it.data->spec.mask & XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID) && xcb_res_client_id_value_value_length(it.data) > 0)
+                    {
+                        pid = xcb_res_client_id_value_value(it.data)[0];
+                        break;
+                    }
+                }
+            }
+#endif
+            windowPidResolved(pendingReply.window, pid, reply != nullptr);
+            break;
+        }
+        case PendingReply::ClientList:
+        {
+            auto propertyReply = static_cast<xcb_get_property_reply_t *>(reply);
+            const bool hasValue = (propertyReply && propertyReply->type != 0);
+            const bool newer = std::none_of(m_pendingReplies.begin(), m_pendingReplies.end(), [](const PendingReply &other) {
+                return (other.type == PendingReply::ClientList);
+            });
+            if (newer)
+            {
+                setClientList(
+                    hasValue ? static_cast<xcb_window_t *>(xcb_get_property_value(propertyReply)) : nullptr,
+                    hasValue ? xcb_get_property_value_length(propertyReply) / 4 : 0
+                );
+            }
+            break;
+        }
+        case PendingReply::WindowNetState:
+        {
+            bool netHidden = false;
+            bool fullscreen = false;
+            auto propertyReply = static_cast<xcb_get_property_reply_t *>(reply);
+            if (propertyReply && propertyReply->type != 0)
+            {
+                const auto states = static_cast<xcb_atom_t *>(xcb_get_property_value(propertyReply));
+                const int count = xcb_get_property_value_length(propertyReply) / 4;
+                netHidden = std::find(states, states + count, _NET_WM_STATE_HIDDEN) != states + count;
+                fullscreen = std::find(states, states + count, _NET_WM_STATE_FULLSCREEN) != states + count;
+            }
+
+            if (pendingReply.window == m_activeWindow)
+                setActiveWindowFullscreen(fullscreen);
+
+            auto it = m_clientWindows.find(pendingReply.window);
+            if (it == m_clientWindows.end())
+                break;
+
+            it->fullscreen = fullscreen;
+            if (it->netHidden != netHidden)
+            {
+                it->netHidden = netHidden;
+                m_clientWindowsChanged = true;
+            }
+            break;
+        }
+        case PendingReply::WindowWmState:
+        {
+            auto it = m_clientWindows.find(pendingReply.window);
+            if (it == m_clientWindows.end())
+                break;
+
+            constexpr uint32_t IconicState = 3;
+            const bool iconic = (propertyValue(reply) == IconicState);
+            if (it->iconic != iconic)
+            {
+                it->iconic = iconic;
+                m_clientWindowsChanged = true;
+            }
+            break;
+        }
+        case PendingReply::WindowGeometry:
+        {
+            auto geometryReply = static_cast<xcb_get_geometry_reply_t *>(reply);
+            if (geometryReply && pendingReply.window == m_activeWindow)
+                m_activeWindowRect.setSize(QSize(geometryReply->width, geometryReply->height));
+            break;
+        }
+        case PendingReply::WindowPosition:
+        {
+            auto positionReply = static_cast<xcb_translate_coordinates_reply_t *>(reply);
+            if (positionReply && pendingReply.window == m_activeWindow)
+            {
+                m_activeWindowRect.moveTo(positionReply->dst_x, positionReply->dst_y);
+                updateActiveRefreshRate();
+            }
+            break;
+        }
+#ifdef USE_XCB_RANDR
+        case PendingReply::ScreenResources:
+        {
+            // Only the newest configuration matters, CRTC replies are matched with it by the order
+            auto resourcesReply = static_cast<xcb_randr_get_screen_resources_current_reply_t *>(reply);
+            const bool newer = std::none_of(m_pendingReplies.begin(), m_pendingReplies.end(), [](const PendingReply &other) {
+                return (other.type == PendingReply::ScreenResources);
+            });
+            if (!resourcesReply || !newer)
+                break;
+
+            m_modeRefreshRates.clear();
+            auto modes = xcb_randr_get_screen_resources_current_modes(resourcesReply);
+            const int modesCount = xcb_randr_get_screen_resources_current_modes_length(resourcesReply);
+            for (int i = 0; i < modesCount; ++i)
+            {
+                const auto &mode = modes[i];
+
+                double vTotal = mode.vtotal;
+                if (mode.mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN)
+                    vTotal *= 2.0;
+                if (mode.mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE)
+                    vTotal /= 2.0;
+
+                if (mode.htotal > 0 && vTotal > 0.0)
+                    m_modeRefreshRates[mode.id] = mode.dot_clock / (mode.htotal * vTotal);
+            }
+
+            m_pendingCrtcs.clear();
+            m_pendingCrtcCount = xcb_randr_get_screen_resources_current_crtcs_length(resourcesReply);
+            auto crtcs = xcb_randr_get_screen_resources_current_crtcs(resourcesReply);
+            for (int i = 0; i < m_pendingCrtcCount; ++i)
+            {
+                const auto cookie = xcb_randr_get_crtc_info(m_conn, crtcs[i], resourcesReply->config_timestamp);
+                m_pendingReplies.push_back({PendingReply::CrtcInfo, cookie.sequence, crtcs[i]});
+            }
+            if (m_pendingCrtcCount == 0)
+            {
+                m_crtcs.clear();
+                updateActiveRefreshRate();
+            }
+            break;
+        }
+        case PendingReply::CrtcInfo:
+        {
+            auto crtcReply = static_cast<xcb_randr_get_crtc_info_reply_t *>(reply);
+            if (crtcReply && crtcReply->mode != 0 && crtcReply->status == XCB_RANDR_SET_CONFIG_SUCCESS)
+            {
+                Crtc crtc;
+                crtc.rect = QRect(crtcReply->x, crtcReply->y, crtcReply->width, crtcReply->height);
+                crtc.refreshRate = m_modeRefreshRates.value(crtcReply->mode);
+                m_pendingCrtcs.push_back(crtc);
+            }
+            if (--m_pendingCrtcCount == 0)
+            {
+                m_crtcs.swap(m_pendingCrtcs);
+                m_pendingCrtcs.clear();
+                updateActiveRefreshRate();
+            }
+            break;
+        }
+#else
+        case PendingReply::ScreenResources:
+        case PendingReply::CrtcInfo:
+            break;
+#endif
+    }
+}
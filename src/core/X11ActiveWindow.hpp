@@ -0,0 +1,206 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "X11Helpers.hpp"
+
+#include <QObject>
+#include <QHash>
+#include <QRect>
+#include <QSet>
+
+#include <deque>
+#include <vector>
+
+class QSocketNotifier;
+
+class X11ActiveWindow : public QObject
+{
+    Q_OBJECT
+
+    // Requests are never waited for, replies are collected when they arrive
+    struct PendingReply
+    {
+        enum Type
+        {
+            ActiveWindow,
+            WindowPid,
+            WindowClientPid, // X-Resource fallback if "_NET_WM_PID" is missing
+            ClientList,
+            WindowNetState,
+            WindowWmState,
+            WindowGeometry,
+            WindowPosition,
+            ScreenResources,
+            CrtcInfo,
+        };
+
+        Type type;
+        unsigned sequence;
+        uint32_t window; // Or CRTC
+    };
+
+    struct Crtc
+    {
+        QRect rect;
+        double refreshRate = 0.0;
+    };
+
+    struct ClientWindow
+    {
+        bool netHidden = false; // "_NET_WM_STATE_HIDDEN"
+        bool iconic = false; // "WM_STATE"
+        bool fullscreen = false; // "_NET_WM_STATE_FULLSCREEN"
+    };
+
+public:
+    X11ActiveWindow();
+    ~X11ActiveWindow();
+
+    inline bool isOk() const;
+
+    // Whether PIDs of windows without "_NET_WM_PID" can be resolved
+    inline bool hasXRes() const;
+
+    // PIDs which have top-level windows, hidden if all of them are minimized or hidden
+    inline const QSet<pid_t> &hiddenPids() const;
+    inline const QSet<pid_t> &visiblePids() const;
+
+    // "_NET_WM_STATE_FULLSCREEN" of the active window
+    inline bool isActiveWindowFullscreen() const;
+
+    // Refresh rate of the monitor showing the active window, 0.0 if unknown
+    inline bool hasRandR() const;
+    inline double activeRefreshRate() const;
+
+private:
+    void requestActiveWindow();
+    void requestWindowPid(xcb_window_t window);
+    void requestWindowClientPid(xcb_window_t window);
+    void requestClientList();
+    void requestWindowStates(xcb_window_t window);
+    void requestActiveWindowGeometry();
+    void requestScreenResources();
+
+    bool isPidPending(xcb_window_t window) const;
+
+    void setActiveWindow(xcb_window_t window);
+    void setActiveWindowPid(pid_t pid);
+    void setActiveWindowFullscreen(bool fullscreen);
+    void windowPidResolved(xcb_window_t window, pid_t pid, bool cache);
+
+    void setClientList(const xcb_window_t *windows, int count);
+    void updateHiddenPids();
+
+    void updateActiveRefreshRate();
+
+    void processEvents();
+    void handleEvent(xcb_generic_event_t *gev);
+    bool processReplies();
+    void handleReply(const PendingReply &pendingReply, void *reply);
+
+signals:
+    void activeWindowPidChanged(pid_t pid);
+    void activeWindowFullscreenChanged();
+    void hiddenPidsChanged();
+    void activeRefreshRateChanged();
+
+private:
+    xcb_connection_t *m_conn = nullptr;
+    xcb_window_t m_root = 0;
+
+    xcb_atom_t _NET_ACTIVE_WINDOW = 0;
+    xcb_atom_t _NET_WM_PID = 0;
+    xcb_atom_t _NET_CLIENT_LIST = 0;
+    xcb_atom_t _NET_WM_STATE = 0;
+    xcb_atom_t _NET_WM_STATE_HIDDEN = 0;
+    xcb_atom_t _NET_WM_STATE_FULLSCREEN = 0;
+    xcb_atom_t WM_STATE = 0;
+
+    bool m_hasXRes = false;
+
+    bool m_hasRandR = false;
+    uint8_t m_randrFirstEvent = 0;
+
+    bool m_ok = false;
+
+    QSocketNotifier *m_notifier = nullptr;
+
+    std::deque<PendingReply> m_pendingReplies;
+
+    QHash<xcb_window_t, pid_t> m_windowPids; // Invalidated by "DestroyNotify" and "_NET_WM_PID" changes
+
+    xcb_window_t m_activeWindow = 0;
+    pid_t m_activeWindowPid = 0;
+    bool m_activeWindowFullscreen = false;
+
+    QHash<xcb_window_t, ClientWindow> m_clientWindows; // From "_NET_CLIENT_LIST"
+    bool m_clientWindowsChanged = false;
+
+    QSet<pid_t> m_hiddenPids;
+    QSet<pid_t> m_visiblePids;
+
+    QRect m_activeWindowRect;
+    QHash<uint32_t, double> m_modeRefreshRates; // RandR mode -> refresh rate
+    std::vector<Crtc> m_crtcs;
+    std::vector<Crtc> m_pendingCrtcs;
+    int m_pendingCrtcCount = 0;
+    double m_activeRefreshRate = 0.0;
+};
+
+/* Inline implementation */
+
+bool X11ActiveWindow::isOk() const
+{
+    return m_ok;
+}
+
+bool X11ActiveWindow::hasXRes() const
+{
+    return m_hasXRes;
+}
+
+const QSet<pid_t> &X11ActiveWindow::hiddenPids() const
+{
+    return m_hiddenPids;
+}
+const QSet<pid_t> &X11ActiveWindow::visiblePids() const
+{
+    return m_visiblePids;
+}
+
+bool X11ActiveWindow::isActiveWindowFullscreen() const
+{
+    return m_activeWindowFullscreen;
+}
+
+bool X11ActiveWindow::hasRandR() const
+{
+    return m_hasRandR;
+}
+double X11ActiveWindow::activeRefreshRate() const
+{
+    return m_activeRefreshRate;
+}
@@ -0,0 +1,217 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "X11IdleMonitor.hpp"
+
+#include <QSocketNotifier>
+#include <QByteArray>
+#include <QDebug>
+
+#include <xcb/xcbext.h>
+#ifdef USE_XCB_SYNC
+#   include <xcb/sync.h>
+#endif
+
+#ifdef USE_XCB_SYNC
+static xcb_sync_int64_t toSyncInt64(int64_t value)
+{
+    return {static_cast<int32_t>(value >> 32), static_cast<uint32_t>(value)};
+}
+static int64_t fromSyncInt64(const xcb_sync_int64_t &value)
+{
+    return (static_cast<int64_t>(value.hi) << 32) | value.lo;
+}
+#endif
+
+X11IdleMonitor::X11IdleMonitor()
+{
+#ifdef USE_XCB_SYNC
+    // Own connection, alarm events are delivered to the client which created the alarm
+    m_conn = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(m_conn))
+        return;
+
+    auto syncExt = xcb_get_extension_data(m_conn, &xcb_sync_id);
+    if (!syncExt || !syncExt->present)
+        return;
+    m_syncFirstEvent = syncExt->first_event;
+
+    if (!XCB_CALL(xcb_sync_initialize, m_conn, 3, 1))
+        return;
+
+    // Milliseconds since the last input event
+    if (auto countersReply = XCB_CALL(xcb_sync_list_system_counters, m_conn))
+    {
+        for (auto it = xcb_sync_list_system_counters_counters_iterator(countersReply.get()); it.rem > 0; xcb_sync_systemcounter_next(&it))
+        {
+            if (QByteArray(xcb_sync_systemcounter_name(it.data), xcb_sync_systemcounter_name_length(it.data)) == "IDLETIME")
+            {
+                m_idleCounter = it.data->counter;
+                break;
+            }
+        }
+    }
+    if (m_idleCounter == 0)
+        return;
+
+    m_idleAlarm = xcb_generate_id(m_conn);
+    m_resetAlarm = xcb_generate_id(m_conn);
+    setAlarms(true);
+
+    m_notifier = new QSocketNotifier(xcb_get_file_descriptor(m_conn), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated,
+            this, &X11IdleMonitor::processEvents);
+
+    m_ok = true;
+#endif
+}
+X11IdleMonitor::~X11IdleMonitor()
+{
+    if (m_notifier)
+        m_notifier->setEnabled(false);
+    if (m_conn)
+        xcb_disconnect(m_conn); // Also destroys the alarms
+}
+
+void X11IdleMonitor::setTimeout(int timeout)
+{
+    timeout = qMax(timeout, 1);
+    if (m_timeout == timeout)
+        return;
+
+    m_timeout = timeout;
+    if (m_ok)
+        setAlarms(false);
+}
+
+void X11IdleMonitor::setAlarms(bool create)
+{
+#ifdef USE_XCB_SYNC
+    const int64_t timeout = static_cast<int64_t>(m_timeout) * 1000;
+
+    // Transitions don't need re-arming, so the alarms stay active with zero delta
+    const struct
+    {
+        uint32_t alarm;
+        uint32_t testType;
+        int64_t value;
+    } alarms[] {
+        {m_idleAlarm, XCB_SYNC_TESTTYPE_POSITIVE_TRANSITION, timeout},
+        {m_resetAlarm, XCB_SYNC_TESTTYPE_NEGATIVE_TRANSITION, timeout - 1},
+    };
+    for (auto &&alarm : alarms)
+    {
+        if (create)
+        {
+            xcb_sync_create_alarm_value_list_t values = {};
+            values.counter = m_idleCounter;
+            values.valueType = XCB_SYNC_VALUETYPE_ABSOLUTE;
+            values.value = toSyncInt64(alarm.value);
+            values.testType = alarm.testType;
+            values.delta = toSyncInt64(0);
+            values.events = 1;
+            xcb_sync_create_alarm_aux(
+                m_conn,
+                alarm.alarm,
+                XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE | XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS,
+                &values
+            );
+        }
+        else
+        {
+            xcb_sync_change_alarm_value_list_t values = {};
+            values.value = toSyncInt64(alarm.value);
+            xcb_sync_change_alarm_aux(m_conn, alarm.alarm, XCB_SYNC_CA_VALUE, &values);
+        }
+    }
+
+    // The counter can be past the timeout already, no transition happens then
+    m_pendingQueries.push_back(xcb_sync_query_counter(m_conn, m_idleCounter).sequence);
+
+    xcb_flush(m_conn);
+#else
+    Q_UNUSED(create)
+#endif
+}
+void X11IdleMonitor::setIdle(bool idle)
+{
+    if (m_idle != idle)
+    {
+        m_idle = idle;
+        emit idleChanged();
+    }
+}
+
+void X11IdleMonitor::processEvents()
+{
+#ifdef USE_XCB_SYNC
+    const int64_t timeout = static_cast<int64_t>(m_timeout) * 1000;
+
+    // Collecting replies can read more events and vice versa
+    for (;;)
+    {
+        bool progress = false;
+
+        while (auto gev = managePtr(xcb_poll_for_event(m_conn)))
+        {
+            progress = true;
+
+            if ((gev->response_type & ~0x80) != m_syncFirstEvent + XCB_SYNC_ALARM_NOTIFY)
+                continue;
+
+            auto aev = reinterpret_cast<xcb_sync_alarm_notify_event_t *>(gev.get());
+            if (aev->alarm == m_idleAlarm || aev->alarm == m_resetAlarm)
+                setIdle(fromSyncInt64(aev->counter_value) >= timeout);
+        }
+
+        while (!m_pendingQueries.empty())
+        {
+            void *reply = nullptr;
+            xcb_generic_error_t *error = nullptr;
+            if (xcb_poll_for_reply(m_conn, m_pendingQueries.front(), &reply, &error) == 0)
+                break;
+
+            m_pendingQueries.pop_front();
+            free(error);
+            progress = true;
+
+            // Only the newest value matters
+            auto counterReply = managePtr(static_cast<xcb_sync_query_counter_reply_t *>(reply));
+            if (counterReply && m_pendingQueries.empty())
+                setIdle(fromSyncInt64(counterReply->counter_value) >= timeout);
+        }
+
+        if (!progress)
+            break;
+    }
+
+    if (xcb_connection_has_error(m_conn))
+    {
+        qWarning() << "X11 connection error, idle monitoring is disabled";
+        m_notifier->setEnabled(false);
+        m_pendingQueries.clear();
+        setIdle(false);
+    }
+#endif
+}
@@ -24,65 +24,71 @@
 
 #pragma once
 
-#include <QFileSystemWatcher>
-#include <QFile>
-#include <QDir>
+#include "X11Helpers.hpp"
 
-#include <optional>
+#include <QObject>
 
-class ExternalControl : public QObject
+#include <deque>
+
+class QSocketNotifier;
+
+// Uses XSync alarms on the "IDLETIME" system counter, so nothing is polled
+class X11IdleMonitor : public QObject
 {
     Q_OBJECT
 
 public:
-    struct AppDescr
-    {
-        QString file;
-        QString name;
-        qint64 pid = 0;
-    };
-
-public:
-    ExternalControl();
-    ~ExternalControl();
+    X11IdleMonitor();
+    ~X11IdleMonitor();
 
     inline bool isOk() const;
 
-    void cleanup();
-
-    inline const std::vector<AppDescr> &applications() const;
-
-    bool setData(const AppDescr &appDescr, double fps, const std::optional<bool> &forceImmediate);
+    inline int timeout() const; // Seconds
+    void setTimeout(int timeout);
 
-    void refresh();
+    // No input for at least "timeout()" seconds
+    inline bool isIdle() const;
 
 private:
-    void dirContentsChanged(const QString &path);
+    void setAlarms(bool create);
+    void setIdle(bool idle);
+
+    void processEvents();
 
 signals:
-    void applicationsAboutToChange();
-    void applicationsChanged();
+    void idleChanged();
 
 private:
-    const QDir m_flimesDir;
-    QFile m_flimesPlaceholderFile;
+    xcb_connection_t *m_conn = nullptr;
 
-    QFileSystemWatcher m_watcher;
+    uint8_t m_syncFirstEvent = 0;
+    uint32_t m_idleCounter = 0;
+    uint32_t m_idleAlarm = 0; // Fires when the counter reaches the timeout
+    uint32_t m_resetAlarm = 0; // Fires on the first input event after that
 
     bool m_ok = false;
-    bool m_cleanupDone = false;
 
-    std::vector<AppDescr> m_applications;
+    QSocketNotifier *m_notifier = nullptr;
+
+    std::deque<unsigned> m_pendingQueries;
+
+    int m_timeout = 300;
+    bool m_idle = false;
 };
 
 /* Inline implementation */
 
-bool ExternalControl::isOk() const
+bool X11IdleMonitor::isOk() const
 {
     return m_ok;
 }
 
-const std::vector<ExternalControl::AppDescr> &ExternalControl::applications() const
+int X11IdleMonitor::timeout() const
+{
+    return m_timeout;
+}
+
+bool X11IdleMonitor::isIdle() const
 {
-    return m_applications;
+    return m_idle;
 }
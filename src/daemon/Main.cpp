@@ -0,0 +1,108 @@
+/*
+    MIT License
+
+    Copyright (c) 2020-2021 Błażej Szczygieł
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "ExternalControl.hpp"
+#include "InstanceLock.hpp"
+#include "FpsPolicy.hpp"
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QSettings>
+#include <QDebug>
+
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <signal.h>
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler([](QtMsgType t, const QMessageLogContext &c, const QString &s) {
+        fprintf(stderr, "%s\n", qUtf8Printable(qFormatLogMessage(t, c, s)));
+        fflush(stderr);
+    });
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(VK_LAYER_FLIMES_DAEMON_NAME);
+    app.setApplicationVersion(VK_LAYER_FLIMES_GUI_VERSION);
+
+    InstanceLock instanceLock;
+    if (!instanceLock.tryLock())
+    {
+        qCritical() << "Application is already running";
+        return -1;
+    }
+
+    // SIGINT and SIGTERM quit, SIGHUP reloads the settings
+    sigset_t sigMask;
+    sigemptyset(&sigMask);
+    sigaddset(&sigMask, SIGINT);
+    sigaddset(&sigMask, SIGTERM);
+    sigaddset(&sigMask, SIGHUP);
+    sigprocmask(SIG_BLOCK, &sigMask, nullptr);
+
+    const int sigFd = signalfd(-1, &sigMask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sigFd < 0)
+    {
+        qCritical() << "Can't create signalfd";
+        return -1;
+    }
+
+    FpsPolicy policy;
+    if (!policy.externalControl()->isOk())
+    {
+        qCritical() << "Can't get apllications list";
+        return -1;
+    }
+
+    QSettings settings(FpsPolicy::settingsFilePath(), QSettings::IniFormat);
+    policy.load(settings);
+
+    QSocketNotifier sigNotifier(sigFd, QSocketNotifier::Read);
+    QObject::connect(&sigNotifier, &QSocketNotifier::activated,
+                     &app, [&] {
+        signalfd_siginfo info;
+        while (read(sigFd, &info, sizeof(info)) == sizeof(info))
+        {
+            if (info.ssi_signo == SIGHUP)
+            {
+                qDebug() << "Reloading settings";
+                settings.sync();
+                policy.load(settings);
+            }
+            else
+            {
+                QCoreApplication::quit();
+            }
+        }
+    });
+
+    const int ret = app.exec();
+
+    sigNotifier.setEnabled(false);
+    close(sigFd);
+
+    policy.shutdown();
+
+    return ret;
+}
@@ -0,0 +1,160 @@
+// Writes, reloads, truncates and compacts an AppSettingsStore file in a temporary directory.
+// Returns non-zero if any check fails.
+
+#include "AppSettingsStore.hpp"
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDebug>
+#include <QFile>
+
+using namespace std;
+
+static int g_failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+
+    qCritical() << "FAILED:" << what;
+    ++g_failures;
+}
+
+static AppSettingsStore::Entry makeEntry(const QString &name, quint16 flags, double activeFps, qint64 lastUsed)
+{
+    AppSettingsStore::Entry entry;
+    entry.name = name;
+    entry.flags = flags;
+    entry.activeFps = activeFps;
+    entry.inactiveFps = activeFps / 2.0;
+    entry.batteryFps = activeFps / 4.0;
+    entry.lastUsed = lastUsed;
+    return entry;
+}
+static bool isEqual(const AppSettingsStore::Entry &a, const AppSettingsStore::Entry &b)
+{
+    return (a.name == b.name && a.flags == b.flags && a.activeFps == b.activeFps && a.inactiveFps == b.inactiveFps && a.batteryFps == b.batteryFps && a.lastUsed == b.lastUsed);
+}
+static bool contains(const vector<AppSettingsStore::Entry> &entries, const AppSettingsStore::Entry &expected)
+{
+    for (auto &&entry : entries)
+    {
+        if (isEqual(entry, expected))
+            return true;
+    }
+    return false;
+}
+
+static vector<AppSettingsStore::Entry> reload(const QString &filePath)
+{
+    AppSettingsStore store(filePath);
+    return store.load();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir tmpDir;
+    check(tmpDir.isValid(), "temporary directory");
+    if (!tmpDir.isValid())
+        return 1;
+
+    const QString filePath = tmpDir.filePath("apps");
+
+    const auto a = makeEntry("a", 0x03, 60.0, 100);
+    const auto b = makeEntry("b", 0x0f, 0.0, 200);
+    const auto aModified = makeEntry("a", 0x07, 30.0, 300);
+    const auto c = makeEntry("c", 0x01, 144.0, 400);
+
+    {
+        AppSettingsStore store(filePath);
+        check(!store.exists(), "no file at start");
+        check(store.load().empty(), "missing file loads empty");
+
+        // Not writable, e.g. the daemon
+        store.put(a);
+        check(store.flush() && !store.exists(), "read-only store doesn't write");
+
+        store.setWritable(true);
+        store.compact({a, b});
+        check(store.flush() && store.exists(), "snapshot written");
+    }
+
+    {
+        const auto entries = reload(filePath);
+        check(entries.size() == 2 && contains(entries, a) && contains(entries, b), "snapshot round trip");
+    }
+
+    qint64 recordSize = 0;
+    {
+        AppSettingsStore store(filePath);
+        store.load();
+        store.setWritable(true);
+
+        const qint64 snapshotSize = QFile(filePath).size();
+        store.put(aModified);
+        store.put(c);
+        check(store.flush(), "journal appended");
+        recordSize = (QFile(filePath).size() - snapshotSize) / 2;
+        check(recordSize > 0, "journal records appended after the snapshot");
+    }
+
+    {
+        // Later records replace earlier ones
+        const auto entries = reload(filePath);
+        check(entries.size() == 3 && contains(entries, aModified) && contains(entries, b) && contains(entries, c), "journal round trip");
+    }
+
+    {
+        // Interrupted append: the last record is cut
+        QFile f(filePath);
+        check(f.resize(f.size() - 3), "truncate the journal tail");
+
+        AppSettingsStore store(filePath);
+        const auto entries = store.load();
+        check(entries.size() == 2 && contains(entries, aModified) && contains(entries, b), "truncated tail is dropped");
+
+        // Compacted when it becomes writable, so new records aren't appended after garbage
+        store.setWritable(true);
+        store.put(c);
+        check(store.flush(), "compacted after truncation");
+    }
+
+    {
+        const auto entries = reload(filePath);
+        check(entries.size() == 3 && contains(entries, aModified) && contains(entries, b) && contains(entries, c), "reload after compaction");
+    }
+
+    {
+        // Many appended records trigger a compaction, the contents stay the same
+        AppSettingsStore store(filePath);
+        store.load();
+        store.setWritable(true);
+        for (int i = 0; i < 200; ++i)
+            store.put(makeEntry("c", 0x01, 1.0 + i, 500 + i));
+        check(store.flush(), "repeated puts");
+
+        check(QFile(filePath).size() < recordSize * 100, "file size bounded by compaction");
+    }
+
+    {
+        const auto entries = reload(filePath);
+        check(entries.size() == 3 && contains(entries, makeEntry("c", 0x01, 200.0, 699)), "reload after automatic compaction");
+    }
+
+    {
+        // Not a store file
+        QFile f(filePath);
+        check(f.open(QFile::WriteOnly | QFile::Truncate) && f.write("garbage") > 0, "write garbage");
+        f.close();
+        check(reload(filePath).empty(), "unknown header loads empty");
+    }
+
+    if (g_failures > 0)
+        return 1;
+
+    qInfo() << "All AppSettingsStore checks passed";
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Runs ThermalSource against a fake "thermal_zone*" tree and checks the resulting scale.
+// Returns non-zero if any check fails.
+
+#include "ThermalSource.hpp"
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDebug>
+#include <QFile>
+#include <QDir>
+
+#include <cmath>
+
+static int g_failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+
+    qCritical() << "FAILED:" << what;
+    ++g_failures;
+}
+static void checkScale(const ThermalSource &thermalSource, double expected, const char *what)
+{
+    if (std::abs(thermalSource.scale() - expected) < 0.001)
+        return;
+
+    qCritical() << "FAILED:" << what << "- scale:" << thermalSource.scale() << "expected:" << expected;
+    ++g_failures;
+}
+
+static bool writeTemperature(const QDir &root, const QString &zone, double celsius)
+{
+    if (!root.mkpath(zone))
+        return false;
+
+    QFile f(root.filePath(zone + "/temp"));
+    if (!f.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+
+    // Millidegrees Celsius, like sysfs
+    return (f.write(QByteArray::number(qRound(celsius * 1000.0)) + "\n") > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir tmpDir;
+    check(tmpDir.isValid(), "temporary directory");
+    if (!tmpDir.isValid())
+        return 1;
+
+    const QDir root(tmpDir.path());
+    const QString emptyRoot = root.filePath("empty"); // Re-setting the root lists the zones again
+
+    ThermalSource thermalSource;
+    thermalSource.setCeiling(85.0);
+
+    thermalSource.setSysfsRoot(root.path());
+    check(!thermalSource.isOk(), "no thermal zones");
+    thermalSource.setEnabled(true);
+    checkScale(thermalSource, 1.0, "no thermal zones");
+
+    check(writeTemperature(root, "thermal_zone0", 60.0), "write thermal_zone0");
+    root.mkpath("cooling_device0"); // Must be ignored
+
+    thermalSource.setSysfsRoot(emptyRoot);
+    thermalSource.setSysfsRoot(root.path());
+    check(thermalSource.isOk(), "one thermal zone");
+    check(std::abs(thermalSource.temperature() - 60.0) < 0.001, "temperature read in degrees");
+    checkScale(thermalSource, 1.0, "far below the target");
+
+    // At the target (5 °C below the ceiling) nothing is throttled yet
+    check(writeTemperature(root, "thermal_zone0", 80.0), "write thermal_zone0");
+    thermalSource.poll();
+    checkScale(thermalSource, 1.0, "at the target");
+
+    // Staying above the target throttles harder on every poll
+    check(writeTemperature(root, "thermal_zone0", 82.0), "write thermal_zone0");
+    thermalSource.poll();
+    checkScale(thermalSource, 0.88, "above the target");
+    thermalSource.poll();
+    checkScale(thermalSource, 0.86, "still above the target");
+
+    // The hottest zone is used, reaching the ceiling throttles fully
+    check(writeTemperature(root, "thermal_zone1", 90.0), "write thermal_zone1");
+    thermalSource.setSysfsRoot(emptyRoot);
+    thermalSource.setSysfsRoot(root.path());
+    checkScale(thermalSource, 0.25, "above the ceiling");
+
+    // Cooling below the ceiling, but not below the target, keeps the throttling
+    check(writeTemperature(root, "thermal_zone0", 84.0), "write thermal_zone0");
+    check(writeTemperature(root, "thermal_zone1", 84.0), "write thermal_zone1");
+    thermalSource.poll();
+    checkScale(thermalSource, 0.25, "above the target after the ceiling");
+
+    // Below the target the scale is restored gradually
+    check(writeTemperature(root, "thermal_zone0", 75.0), "write thermal_zone0");
+    check(writeTemperature(root, "thermal_zone1", 75.0), "write thermal_zone1");
+    thermalSource.poll();
+    checkScale(thermalSource, 0.55, "below the target");
+    thermalSource.poll();
+    checkScale(thermalSource, 0.6, "longer below the target");
+    for (int i = 0; i < 20; ++i)
+        thermalSource.poll();
+    checkScale(thermalSource, 1.0, "restored");
+
+    // Unreadable values are skipped
+    check(writeTemperature(root, "thermal_zone1", 95.0), "write thermal_zone1");
+    {
+        QFile f(root.filePath("thermal_zone0/temp"));
+        check(f.open(QFile::WriteOnly | QFile::Truncate) && f.write("invalid\n") > 0, "write invalid thermal_zone0");
+    }
+    thermalSource.poll();
+    checkScale(thermalSource, 0.25, "invalid zone skipped");
+
+    thermalSource.setEnabled(false);
+    checkScale(thermalSource, 1.0, "disabled");
+    check(thermalSource.temperature() == 0.0, "temperature reset when disabled");
+
+    if (g_failures > 0)
+        return 1;
+
+    qInfo() << "All ThermalSource checks passed";
+    return 0;
+}